@@ -24,15 +24,43 @@
 #include "Utils/Utils.hpp"
 
 #include "Graphics/Objects/Model.hpp"
+#include "Graphics/Objects/ModelLoader.hpp"
 #include "Graphics/Objects/Material.hpp"
+#include "Graphics/Scene/ModelInstances.hpp"
 
 int main()
 {
     // logMessage(3, "VRTestProj is starting up.");
     GraphicsManager gfxManager;
 
-    // load sample asset
-    // Model suzanne = Model("assets/suzanne.obj");
+    // placements of loaded models, every copy shares the model's mesh data
+    ModelInstances instances;
+    DrawList drawList;
+
+    // load sample asset in the background, the frame loop below keeps running meanwhile
+    ModelHandle suzanne = loadModelAsync("assets/suzanne.obj", ModelOptions(), [&instances](const ModelHandle& handle)
+    {
+        if (auto model = handle.model())
+        {
+            logMessage(3, logFormat("Model ready: ", handle.path(), " (", model->getMeshes().size(), " meshes)"), {"Graphics", "Model"});
+
+            // a grid of copies, drawn as one instanced draw per mesh range
+            for (int x = -2; x <= 2; ++x)
+            {
+                for (int z = -2; z <= 2; ++z)
+                {
+                    glm::mat4 transform(1.0f);
+                    transform[3][0] = 3.0f * x;
+                    transform[3][2] = 3.0f * z;
+                    instances.add(model, transform);
+                }
+            }
+        }
+        else
+        {
+            logMessage(2, "Model failed to load: " + handle.path(), {"Graphics", "Model"});
+        }
+    });
 
     // load sample material
     // Material simpleMaterial("testshaders", "TestMaterial");
@@ -54,10 +82,16 @@ int main()
             }
             else
             {
-                logMessage(3, "SDL Event Poll: Type " + std::to_string(event.type), {"SDL"});
+                logMessage(3, logFormat("SDL Event Poll: Type ", event.type), {"SDL"});
             }
         }
 
+        // completion callbacks of background loads run here, on the main thread
+        dispatchModelCallbacks();
+
+        // one transform upload and a handful of instanced draws for the renderer
+        instances.buildDrawList(DrawListView(), drawList);
+
         // Here would go rendering and other per-frame logic
 
         // For demonstration, we'll just run for a short time
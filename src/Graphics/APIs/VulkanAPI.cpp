@@ -882,6 +882,7 @@ bool VulkanAPI::createSwapchain(){
         logMessage(1, ss.str(), {"Graphics", "Vulkan"});
         return false;
     }
+    swapchainFormat_ = chosenFormat.format;
     logMessage(3, "Vulkan swapchain created successfully.", {"Graphics", "Vulkan"});
     return true;
 }
@@ -916,7 +917,7 @@ bool VulkanAPI::generateSwapchainImageViews(){
             .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
             .image = swapchainImages_[i],
             .viewType = VK_IMAGE_VIEW_TYPE_2D,
-            .format = VK_FORMAT_B8G8R8A8_SRGB,
+            .format = swapchainFormat_,
             .components = {
                 .r = VK_COMPONENT_SWIZZLE_IDENTITY,
                 .g = VK_COMPONENT_SWIZZLE_IDENTITY,
@@ -943,10 +944,36 @@ bool VulkanAPI::generateSwapchainImageViews(){
     return true;
 }
 
+VkFormat VulkanAPI::findDepthFormat(){
+    const VkFormat candidates[] = {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D16_UNORM};
+    for (VkFormat format : candidates)
+    {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice_, format, &properties);
+        if (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+        {
+            return format;
+        }
+    }
+    return VK_FORMAT_UNDEFINED;
+}
+
 bool VulkanAPI::initAPI()
 {
     logMessage(3, "Initializing Vulkan API...", {"Graphics", "Vulkan"});
 
+    // startup timing report, one line per phase
+    auto initStart = std::chrono::steady_clock::now();
+    auto phaseStart = initStart;
+    std::ostringstream timings;
+    timings << std::fixed << std::setprecision(2);
+    auto endPhase = [&](const char *phase)
+    {
+        auto now = std::chrono::steady_clock::now();
+        timings << "\n  " << std::left << std::setw(18) << phase << std::chrono::duration<double, std::milli>(now - phaseStart).count() << " ms";
+        phaseStart = now;
+    };
+
     if (openXRManager_ == nullptr || !openXRManager_->isXRValid())
     {
         logMessage(2, "OpenXR not available or valid, proceeding without OpenXR integration.", {"Graphics", "Vulkan", "OpenXR"});
@@ -1020,6 +1047,7 @@ bool VulkanAPI::initAPI()
         logMessage(1, "Failed to create Vulkan instance.", {"Graphics", "Vulkan"});
         return false;
     }
+    endPhase("Instance");
 
     // Fetch and select physical device
     if (!fetchPhysicalDevices())
@@ -1037,6 +1065,7 @@ bool VulkanAPI::initAPI()
         cleanup();
         return false;
     }
+    endPhase("Physical device");
 
     // TODO : Create SDL Surface if SDL is available
     if(!createSDLSurface())
@@ -1058,6 +1087,14 @@ bool VulkanAPI::initAPI()
         cleanup();
         return false;
     }
+    endPhase("Logical device");
+
+    // a missing or stale cache file only means a cold start, never a failed init
+    if (!pipelineCache_.create(physicalDevice_, logicalDevice_, pipelineCacheDirectory_))
+    {
+        logMessage(2, "Proceeding without a Vulkan pipeline cache.", {"Graphics", "Vulkan"});
+    }
+    endPhase(pipelineCache_.isWarm() ? "Pipeline cache" : "Pipeline cache *");
 
     if (!createSwapchain()){
         logMessage(1, "Failed to create swapchain.", {"Graphics", "Vulkan"});
@@ -1070,9 +1107,31 @@ bool VulkanAPI::initAPI()
         cleanup();
         return false;
     }
+    endPhase("Swapchain");
 
+    // every material under SHADER_BINARY_DIR builds on the pool while startup continues,
+    // the renderer waits on the futures from getPipelineBuilder() when it needs them
+    // render passes must match the swapchain, which may not have gotten its preferred format
+    VulkanPipelineTargets targets;
+    targets.colorFormat = swapchainFormat_;
+    targets.depthFormat = findDepthFormat();
+    if (targets.depthFormat == VK_FORMAT_UNDEFINED)
+    {
+        logMessage(2, "No supported depth format, pipelines are built without depth.", {"Graphics", "Vulkan"});
+    }
+    pipelineBuilder_ = std::make_unique<VulkanPipelineBuilder>(logicalDevice_, pipelineCache_, targets);
+    pipelineBuilder_->buildAll();
+    endPhase("Pipelines queued");
 
-
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(2)
+           << "Vulkan startup took " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - initStart).count() << " ms:"
+           << timings.str();
+    if (!pipelineCache_.isWarm())
+    {
+        report << "\n  (* cold pipeline cache, pipelines compile from scratch this run)";
+    }
+    logMessage(3, report.str(), {"Graphics", "Vulkan"});
 
     logMessage(3, "Vulkan API initialized successfully.", {"Graphics", "Vulkan"});
     initialized_ = true;
@@ -1099,6 +1158,17 @@ bool VulkanAPI::cleanup()
 
     logMessage(3, "Cleaning up Vulkan API...", {"Graphics", "Vulkan"});
 
+    // waits for builds still running
+    pipelineBuilder_.reset();
+
+    // pipelines built this run are compiled once, the next launch loads them
+    if (pipelineCache_.get() != VK_NULL_HANDLE)
+    {
+        pipelineCache_.logReport();
+        pipelineCache_.save();
+        pipelineCache_.destroy();
+    }
+
     if (logicalDevice_ != VK_NULL_HANDLE)
     {
         vkDestroyDevice(logicalDevice_, nullptr);
@@ -4,6 +4,8 @@
 #ifdef VULKAN_LINKED
 
 #include "GraphicsAPI.h"
+#include "VulkanPipelineBuilder.h"
+#include "VulkanPipelineCache.h"
 
 #include "Utils/Utils.hpp"
 #include "OpenXR/XRUtils.hpp"
@@ -38,6 +40,12 @@ public:
     bool getGraphicsBinding(XrGraphicsBindingVulkanKHR &graphicsBinding);
     bool createSDLSurface();
 
+    VkDevice getDevice() const { return logicalDevice_; }
+    // shared by every pipeline build, any thread may create pipelines through it
+    VulkanPipelineCache &getPipelineCache() { return pipelineCache_; }
+    // material pipelines, queued on the thread pool during initAPI; null before
+    VulkanPipelineBuilder *getPipelineBuilder() { return pipelineBuilder_.get(); }
+
 private:
     VkInstance instance_;
     bool initialized_;
@@ -100,11 +108,21 @@ private:
     VkQueue SDLPresentQueue_;
 
     VkSwapchainKHR swapchain_  = VK_NULL_HANDLE;
+    // the surface format createSwapchain picked, image views and render passes use it
+    VkFormat swapchainFormat_ = VK_FORMAT_UNDEFINED;
     bool createSwapchain();
 
+    // first depth format the device can attach, VK_FORMAT_UNDEFINED when none
+    VkFormat findDepthFormat();
+
     std::vector<VkImage> swapchainImages_;
     std::vector<VkImageView> swapchainImageViews_;
     bool generateSwapchainImageViews();
+
+    // pipeline cache, loaded once the device exists and saved in cleanup
+    VulkanPipelineCache pipelineCache_;
+    std::string pipelineCacheDirectory_ = "cache/pipelines";
+    std::unique_ptr<VulkanPipelineBuilder> pipelineBuilder_;
 };
 
 #endif // VULKAN_LINKED
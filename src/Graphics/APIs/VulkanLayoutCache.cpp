@@ -0,0 +1,188 @@
+#include "VulkanLayoutCache.h"
+
+#ifdef VULKAN_LINKED
+
+#include "Utils/Hash.hpp"
+#include "Utils/Utils.hpp"
+
+namespace
+{
+    VkDescriptorType descriptorType(ShaderResourceType type)
+    {
+        switch (type)
+        {
+        case ShaderResourceType::Sampler:
+            return VK_DESCRIPTOR_TYPE_SAMPLER;
+        case ShaderResourceType::CombinedImageSampler:
+            return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        case ShaderResourceType::SampledImage:
+            return VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        case ShaderResourceType::StorageImage:
+            return VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        case ShaderResourceType::UniformTexelBuffer:
+            return VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+        case ShaderResourceType::StorageTexelBuffer:
+            return VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+        case ShaderResourceType::UniformBuffer:
+            return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        case ShaderResourceType::StorageBuffer:
+            return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        case ShaderResourceType::InputAttachment:
+            return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+        case ShaderResourceType::AccelerationStructure:
+            return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+        }
+        return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+    }
+
+    void appendKey(std::string &key, uint32_t value)
+    {
+        key.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+}
+
+size_t VulkanLayoutCache::KeyHash::operator()(const std::string &key) const
+{
+    return static_cast<size_t>(hashBytes(reinterpret_cast<const uint8_t *>(key.data()), key.size()));
+}
+
+VulkanLayoutCache::VulkanLayoutCache(VkDevice device) : device_(device)
+{
+}
+
+VulkanLayoutCache::~VulkanLayoutCache()
+{
+    for (auto &entry : pipelineLayouts_)
+    {
+        vkDestroyPipelineLayout(device_, entry.second, nullptr);
+    }
+    for (auto &entry : setLayouts_)
+    {
+        vkDestroyDescriptorSetLayout(device_, entry.second, nullptr);
+    }
+}
+
+VkDescriptorSetLayout VulkanLayoutCache::getSetLayout(const ShaderResourceBinding *bindings, size_t count, VkShaderStageFlags stageFlags)
+{
+    std::string key;
+    appendKey(key, stageFlags);
+    for (size_t i = 0; i < count; ++i)
+    {
+        appendKey(key, bindings[i].binding);
+        appendKey(key, static_cast<uint32_t>(bindings[i].type));
+        appendKey(key, bindings[i].count);
+    }
+    auto found = setLayouts_.find(key);
+    if (found != setLayouts_.end())
+    {
+        return found->second;
+    }
+
+    std::vector<VkDescriptorSetLayoutBinding> layoutBindings(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        layoutBindings[i].binding = bindings[i].binding;
+        layoutBindings[i].descriptorType = descriptorType(bindings[i].type);
+        layoutBindings[i].descriptorCount = bindings[i].count;
+        layoutBindings[i].stageFlags = stageFlags;
+    }
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
+    layoutInfo.pBindings = layoutBindings.data();
+
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkResult result = vkCreateDescriptorSetLayout(device_, &layoutInfo, nullptr, &setLayout);
+    if (result != VK_SUCCESS)
+    {
+        logMessage(2, logFormat("Failed to create descriptor set layout. VkResult: ", result), {"Graphics", "Vulkan", "Material"});
+        return VK_NULL_HANDLE;
+    }
+    setLayouts_.emplace(std::move(key), setLayout);
+    return setLayout;
+}
+
+bool VulkanLayoutCache::getLayout(const std::vector<ShaderResourceBinding> &bindings, uint32_t pushConstantSize, bool compute, VulkanMaterialLayout &layout)
+{
+    layout = VulkanMaterialLayout();
+    layout.stageFlags = compute ? VK_SHADER_STAGE_COMPUTE_BIT : VK_SHADER_STAGE_ALL_GRAPHICS;
+    // push constant ranges are counted in whole words
+    pushConstantSize = (pushConstantSize + 3u) & ~3u;
+    layout.pushConstantSize = pushConstantSize;
+
+    for (const ShaderResourceBinding &binding : bindings)
+    {
+        if (binding.count == 0)
+        {
+            // would need descriptor indexing (variable descriptor counts), which the device does not enable
+            logMessage(2, logFormat("Runtime sized descriptor array at set ", binding.set, " binding ", binding.binding, " is not supported"), {"Graphics", "Vulkan", "Material"});
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t setCount = bindings.empty() ? 0 : bindings.back().set + 1;
+    layout.setLayouts.resize(setCount, VK_NULL_HANDLE);
+    size_t begin = 0;
+    for (uint32_t set = 0; set < setCount; ++set)
+    {
+        size_t end = begin;
+        while (end < bindings.size() && bindings[end].set == set)
+        {
+            ++end;
+        }
+        layout.setLayouts[set] = getSetLayout(bindings.data() + begin, end - begin, layout.stageFlags);
+        if (layout.setLayouts[set] == VK_NULL_HANDLE)
+        {
+            return false;
+        }
+        begin = end;
+    }
+
+    // set layout handles are unique per content, so they identify the pipeline layout
+    std::string key;
+    appendKey(key, layout.stageFlags);
+    appendKey(key, pushConstantSize);
+    for (VkDescriptorSetLayout setLayout : layout.setLayouts)
+    {
+        key.append(reinterpret_cast<const char *>(&setLayout), sizeof(setLayout));
+    }
+    auto found = pipelineLayouts_.find(key);
+    if (found != pipelineLayouts_.end())
+    {
+        layout.pipelineLayout = found->second;
+        return true;
+    }
+
+    VkPushConstantRange pushConstants{layout.stageFlags, 0, pushConstantSize};
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = setCount;
+    layoutInfo.pSetLayouts = layout.setLayouts.data();
+    layoutInfo.pushConstantRangeCount = pushConstantSize != 0 ? 1 : 0;
+    layoutInfo.pPushConstantRanges = &pushConstants;
+
+    VkResult result = vkCreatePipelineLayout(device_, &layoutInfo, nullptr, &layout.pipelineLayout);
+    if (result != VK_SUCCESS)
+    {
+        logMessage(2, logFormat("Failed to create pipeline layout. VkResult: ", result), {"Graphics", "Vulkan", "Material"});
+        layout.pipelineLayout = VK_NULL_HANDLE;
+        return false;
+    }
+    pipelineLayouts_.emplace(std::move(key), layout.pipelineLayout);
+    return true;
+}
+
+size_t VulkanLayoutCache::setLayoutCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return setLayouts_.size();
+}
+
+size_t VulkanLayoutCache::pipelineLayoutCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pipelineLayouts_.size();
+}
+
+#endif // VULKAN_LINKED
@@ -0,0 +1,66 @@
+#ifndef VULKANLAYOUTCACHE_H
+#define VULKANLAYOUTCACHE_H
+
+#ifdef VULKAN_LINKED
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "Graphics/Objects/ShaderReflection.hpp"
+
+// descriptor set layouts and pipeline layouts derived from shader reflection, shared
+//
+// layouts are keyed by a hash of their contents, two materials whose shaders declare
+// the same set get the same VkDescriptorSetLayout and two with the same sets and push
+// constants the same VkPipelineLayout; bindings are visible to every graphics stage (or
+// to compute), so which stage happens to read a binding never splits a layout, and a
+// set bound for one material stays valid for the next one that declares it alike
+
+struct VulkanMaterialLayout
+{
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    // indexed by set number, sets a material skips get the shared empty layout
+    std::vector<VkDescriptorSetLayout> setLayouts;
+    uint32_t pushConstantSize = 0;
+    VkShaderStageFlags stageFlags = 0;
+};
+
+class VulkanLayoutCache
+{
+public:
+    explicit VulkanLayoutCache(VkDevice device);
+    // destroys every layout it handed out
+    ~VulkanLayoutCache();
+
+    VulkanLayoutCache(const VulkanLayoutCache &) = delete;
+    VulkanLayoutCache &operator=(const VulkanLayoutCache &) = delete;
+
+    // layout for merged bindings of a material's stages (mergeShaderBindings, sorted by set
+    // and binding) and its largest push constant block; safe to call from several threads
+    bool getLayout(const std::vector<ShaderResourceBinding> &bindings, uint32_t pushConstantSize, bool compute, VulkanMaterialLayout &layout);
+
+    size_t setLayoutCount() const;
+    size_t pipelineLayoutCount() const;
+
+private:
+    struct KeyHash
+    {
+        size_t operator()(const std::string &key) const;
+    };
+
+    VkDevice device_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, VkDescriptorSetLayout, KeyHash> setLayouts_;
+    std::unordered_map<std::string, VkPipelineLayout, KeyHash> pipelineLayouts_;
+
+    // callers hold mutex_
+    VkDescriptorSetLayout getSetLayout(const ShaderResourceBinding *bindings, size_t count, VkShaderStageFlags stageFlags);
+};
+
+#endif // VULKAN_LINKED
+#endif // VULKANLAYOUTCACHE_H
@@ -0,0 +1,545 @@
+#include "VulkanPipelineBuilder.h"
+
+#ifdef VULKAN_LINKED
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+
+#include "Graphics/Objects/Model.hpp"
+#include "Graphics/Scene/ModelInstances.hpp"
+#include "Utils/Utils.hpp"
+
+namespace
+{
+    // the shader's binary outlives the pipeline build, so its entry point name can be pointed at
+    VkPipelineShaderStageCreateInfo stageInfo(VkShaderStageFlagBits stage, VkShaderModule module, const ShaderHandle &shader,
+                                              const VkSpecializationInfo *specialization)
+    {
+        VkPipelineShaderStageCreateInfo info{};
+        info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        info.stage = stage;
+        info.module = module;
+        info.pName = shader->reflection().entryPoint.c_str();
+        info.pSpecializationInfo = specialization;
+        return info;
+    }
+
+    struct StageSpecialization
+    {
+        std::vector<VkSpecializationMapEntry> entries;
+        std::vector<VkBool32> values;
+        VkSpecializationInfo info{};
+    };
+
+    // sets the stage's bool specialization constants named after feature keys, the others
+    // keep the defaults compiled into the binary; null when the stage has none to set
+    const VkSpecializationInfo *specialize(const ShaderReflection &reflection, const Material &material, ShaderFeatureMask features,
+                                           StageSpecialization &specialization)
+    {
+        for (const ShaderSpecConstant &constant : reflection.specConstants)
+        {
+            ShaderFeatureMask bit = constant.boolean ? material.featureBit(constant.name) : 0;
+            if (bit == 0)
+            {
+                continue;
+            }
+            uint32_t offset = static_cast<uint32_t>(specialization.values.size() * sizeof(VkBool32));
+            specialization.entries.push_back({constant.constantId, offset, sizeof(VkBool32)});
+            specialization.values.push_back((features & bit) != 0 ? VK_TRUE : VK_FALSE);
+        }
+        if (specialization.entries.empty())
+        {
+            return nullptr;
+        }
+        specialization.info.mapEntryCount = static_cast<uint32_t>(specialization.entries.size());
+        specialization.info.pMapEntries = specialization.entries.data();
+        specialization.info.dataSize = specialization.values.size() * sizeof(VkBool32);
+        specialization.info.pData = specialization.values.data();
+        return &specialization.info;
+    }
+
+    struct VertexAttribute
+    {
+        uint32_t binding;
+        VkFormat format;
+        uint32_t offset;
+    };
+
+    // by location, see the header
+    const VertexAttribute kVertexAttributes[] = {
+        {0, VK_FORMAT_R32G32B32_SFLOAT, static_cast<uint32_t>(offsetof(Vertex, position))},
+        {0, VK_FORMAT_R32G32B32_SFLOAT, static_cast<uint32_t>(offsetof(Vertex, normal))},
+        {0, VK_FORMAT_R32G32_SFLOAT, static_cast<uint32_t>(offsetof(Vertex, texCoord))},
+        {0, VK_FORMAT_R32G32B32_SFLOAT, static_cast<uint32_t>(offsetof(Vertex, color))},
+        {1, VK_FORMAT_R32G32B32A32_SFLOAT, 0},
+        {1, VK_FORMAT_R32G32B32A32_SFLOAT, 16},
+        {1, VK_FORMAT_R32G32B32A32_SFLOAT, 32}};
+    constexpr uint32_t kVertexAttributeCount = sizeof(kVertexAttributes) / sizeof(kVertexAttributes[0]);
+}
+
+VulkanPipelineBuilder::VulkanPipelineBuilder(VkDevice device, VulkanPipelineCache &pipelineCache, const VulkanPipelineTargets &targets, ThreadPool &pool)
+    : device_(device), pipelineCache_(pipelineCache), targets_(targets), pool_(pool), layouts_(device)
+{
+    if (targets_.renderPass == VK_NULL_HANDLE && !createRenderPass())
+    {
+        logMessage(2, "Failed to create render pass for pipeline builds, graphics pipelines will fail.", {"Graphics", "Vulkan"});
+    }
+}
+
+VulkanPipelineBuilder::~VulkanPipelineBuilder()
+{
+    wait();
+
+    for (auto &entry : materials_)
+    {
+        for (const std::unique_ptr<VulkanMaterialPipeline> &pipeline : entry.second->built_)
+        {
+            if (pipeline == nullptr)
+            {
+                continue;
+            }
+            if (pipeline->graphics != VK_NULL_HANDLE)
+            {
+                vkDestroyPipeline(device_, pipeline->graphics, nullptr);
+            }
+            if (pipeline->compute != VK_NULL_HANDLE)
+            {
+                vkDestroyPipeline(device_, pipeline->compute, nullptr);
+            }
+        }
+    }
+    for (auto &entry : modules_)
+    {
+        vkDestroyShaderModule(device_, entry.second, nullptr);
+    }
+    if (ownsRenderPass_)
+    {
+        vkDestroyRenderPass(device_, targets_.renderPass, nullptr);
+    }
+}
+
+bool VulkanPipelineBuilder::createRenderPass()
+{
+    std::vector<VkAttachmentDescription> attachments;
+    VkAttachmentDescription color{};
+    color.format = targets_.colorFormat;
+    color.samples = VK_SAMPLE_COUNT_1_BIT;
+    color.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    color.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    color.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    color.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    color.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    color.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    attachments.push_back(color);
+
+    VkAttachmentReference colorReference{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    VkAttachmentReference depthReference{1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorReference;
+    if (targets_.depthFormat != VK_FORMAT_UNDEFINED)
+    {
+        VkAttachmentDescription depth = color;
+        depth.format = targets_.depthFormat;
+        depth.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depth.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        attachments.push_back(depth);
+        subpass.pDepthStencilAttachment = &depthReference;
+    }
+
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+
+    if (vkCreateRenderPass(device_, &renderPassInfo, nullptr, &targets_.renderPass) != VK_SUCCESS)
+    {
+        targets_.renderPass = VK_NULL_HANDLE;
+        return false;
+    }
+    targets_.subpass = 0;
+    ownsRenderPass_ = true;
+    return true;
+}
+
+std::vector<std::string> VulkanPipelineBuilder::discoverMaterials()
+{
+    std::vector<std::string> materials;
+    std::error_code error;
+    std::filesystem::path root(SHADER_BINARY_DIR);
+    if (!std::filesystem::is_directory(root, error))
+    {
+        logMessage(2, "Shader binary directory does not exist: " + root.string(), {"Graphics", "Material", "Slang"});
+        return materials;
+    }
+
+    for (std::filesystem::recursive_directory_iterator it(root, error), end; !error && it != end; it.increment(error))
+    {
+        if (!it->is_directory(error))
+        {
+            continue;
+        }
+        for (const auto &entry : std::filesystem::directory_iterator(it->path(), error))
+        {
+            if (entry.path().extension() == ".spv")
+            {
+                materials.push_back(std::filesystem::relative(it->path(), root, error).generic_string());
+                break;
+            }
+        }
+    }
+    std::sort(materials.begin(), materials.end());
+    return materials;
+}
+
+VulkanMaterialPermutations &VulkanPipelineBuilder::permutationsOf(const std::string &material)
+{
+    std::unique_ptr<VulkanMaterialPermutations> &permutations = materials_[material];
+    if (permutations == nullptr)
+    {
+        permutations.reset(new VulkanMaterialPermutations(material));
+    }
+    return *permutations;
+}
+
+VulkanPipelineFuture VulkanPipelineBuilder::build(const std::string &material, ShaderFeatureMask features)
+{
+    if (features >= kShaderPermutationCount)
+    {
+        logMessage(2, logFormat("Feature mask ", features, " of material ", material, " exceeds ", kMaxShaderFeatures, " feature keys"), {"Graphics", "Vulkan", "Material"});
+        std::promise<VulkanMaterialPipeline> rejected;
+        rejected.set_value(VulkanMaterialPipeline{material, features});
+        return rejected.get_future().share();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    VulkanMaterialPermutations &permutations = permutationsOf(material);
+    VulkanPipelineFuture &future = permutations.builds_[features];
+    if (!future.valid())
+    {
+        future = pool_.submit([this, &permutations, features]()
+        {
+            return buildMaterial(permutations, features);
+        }).share();
+    }
+    return future;
+}
+
+const VulkanMaterialPermutations &VulkanPipelineBuilder::getPermutations(const std::string &material)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return permutationsOf(material);
+}
+
+std::vector<VulkanPipelineFuture> VulkanPipelineBuilder::buildAll()
+{
+    std::vector<std::string> materials = discoverMaterials();
+    logMessage(3, logFormat("Building pipelines for ", materials.size(), " materials on ", pool_.threadCount(), " threads"), {"Graphics", "Vulkan", "Material"});
+
+    std::vector<VulkanPipelineFuture> futures;
+    futures.reserve(materials.size());
+    for (const std::string &material : materials)
+    {
+        futures.push_back(build(material));
+    }
+    return futures;
+}
+
+void VulkanPipelineBuilder::wait()
+{
+    std::vector<VulkanPipelineFuture> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto &entry : materials_)
+        {
+            for (const VulkanPipelineFuture &future : entry.second->builds_)
+            {
+                if (future.valid())
+                {
+                    pending.push_back(future);
+                }
+            }
+        }
+    }
+    for (const VulkanPipelineFuture &future : pending)
+    {
+        future.wait();
+    }
+}
+
+VulkanMaterialPipeline VulkanPipelineBuilder::buildMaterial(VulkanMaterialPermutations &permutations, ShaderFeatureMask features)
+{
+    auto start = std::chrono::steady_clock::now();
+    const std::string &material = permutations.name_;
+
+    std::call_once(permutations.loaded_, [&permutations]()
+    {
+        permutations.material_ = std::make_shared<const Material>(permutations.name_, permutations.name_);
+    });
+
+    VulkanMaterialPipeline result;
+    result.name = material;
+    result.features = features;
+    result.material = permutations.material_;
+
+    if ((features & ~result.material->featureMask()) != 0)
+    {
+        logMessage(2, logFormat("Material ", material, " has no feature keys for bits ", features & ~result.material->featureMask()), {"Graphics", "Vulkan", "Material"});
+        return result;
+    }
+    if (!result.material->hasVariant(features))
+    {
+        logMessage(2, logFormat("Material ", material, " has no compiled variant for features ", features, ", declare it in its .permutations file"), {"Graphics", "Vulkan", "Material"});
+        return result;
+    }
+
+    if (result.material->hasShader(ShaderStage::Vertex))
+    {
+        result.graphics = createGraphicsPipeline(*result.material, features, material, result.graphicsLayout);
+    }
+    if (result.material->hasShader(ShaderStage::Compute))
+    {
+        result.compute = createComputePipeline(*result.material, features, material, result.computeLayout);
+    }
+
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (result.valid())
+    {
+        logMessage(4, logFormat("Built pipelines for material ", material, " features ", features, " in ", milliseconds, " ms"), {"Graphics", "Vulkan", "Material"});
+        permutations.built_[features] = std::make_unique<VulkanMaterialPipeline>(result);
+        permutations.pipelines_[features].store(permutations.built_[features].get(), std::memory_order_release);
+    }
+    else
+    {
+        logMessage(2, logFormat("No pipeline could be built for material ", material, " features ", features), {"Graphics", "Vulkan", "Material"});
+    }
+    return result;
+}
+
+VkShaderModule VulkanPipelineBuilder::getShaderModule(const ShaderHandle &shader)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = modules_.find(shader->hash());
+        if (found != modules_.end())
+        {
+            return found->second;
+        }
+    }
+
+    // created outside the lock, two threads racing on one binary keep the first module
+    VkShaderModuleCreateInfo moduleInfo{};
+    moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleInfo.codeSize = shader->size();
+    moduleInfo.pCode = shader->code();
+    VkShaderModule module = VK_NULL_HANDLE;
+    VkResult result = vkCreateShaderModule(device_, &moduleInfo, nullptr, &module);
+    if (result != VK_SUCCESS)
+    {
+        logMessage(2, logFormat("Failed to create shader module for ", shader->path(), ". VkResult: ", result), {"Graphics", "Vulkan", "Material"});
+        return VK_NULL_HANDLE;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto inserted = modules_.emplace(shader->hash(), module);
+    if (!inserted.second)
+    {
+        vkDestroyShaderModule(device_, module, nullptr);
+    }
+    return inserted.first->second;
+}
+
+VkPipeline VulkanPipelineBuilder::createGraphicsPipeline(const Material &material, ShaderFeatureMask features, const std::string &name, VulkanMaterialLayout &layout)
+{
+    if (targets_.renderPass == VK_NULL_HANDLE)
+    {
+        return VK_NULL_HANDLE;
+    }
+
+    std::vector<VkPipelineShaderStageCreateInfo> stages;
+    StageSpecialization specializations[3];
+    std::vector<ShaderResourceBinding> resources;
+    uint32_t pushConstantSize = 0;
+    const std::pair<ShaderStage, VkShaderStageFlagBits> graphicsStages[] = {
+        {ShaderStage::Vertex, VK_SHADER_STAGE_VERTEX_BIT},
+        {ShaderStage::Geometry, VK_SHADER_STAGE_GEOMETRY_BIT},
+        {ShaderStage::Fragment, VK_SHADER_STAGE_FRAGMENT_BIT}};
+    for (const auto &[stage, stageBit] : graphicsStages)
+    {
+        if (!material.hasShader(stage))
+        {
+            continue;
+        }
+        const ShaderHandle &shader = material.getShader(stage, features);
+        if (shader == nullptr)
+        {
+            logMessage(2, logFormat("Variant of material ", name, " for features ", features, " lacks its ", shaderStageName(stage), " stage"), {"Graphics", "Vulkan", "Material"});
+            return VK_NULL_HANDLE;
+        }
+        const ShaderReflection &reflection = shader->reflection();
+        if (!reflection.valid)
+        {
+            return VK_NULL_HANDLE;
+        }
+        if (!mergeShaderBindings(resources, reflection.bindings))
+        {
+            logMessage(2, logFormat("Stages of material ", name, " declare one binding with different types"), {"Graphics", "Vulkan", "Material"});
+            return VK_NULL_HANDLE;
+        }
+        pushConstantSize = std::max(pushConstantSize, reflection.pushConstantSize);
+
+        VkShaderModule module = getShaderModule(shader);
+        if (module == VK_NULL_HANDLE)
+        {
+            return VK_NULL_HANDLE;
+        }
+        StageSpecialization &specialization = specializations[stages.size()];
+        stages.push_back(stageInfo(stageBit, module, shader, specialize(reflection, material, features, specialization)));
+    }
+    if (!layouts_.getLayout(resources, pushConstantSize, false, layout))
+    {
+        logMessage(2, "Failed to derive pipeline layout for material: " + name, {"Graphics", "Vulkan", "Material"});
+        return VK_NULL_HANDLE;
+    }
+
+    // attributes for the locations the vertex shader reads, bindings only when used
+    std::vector<VkVertexInputAttributeDescription> attributes;
+    bool bindingUsed[2] = {false, false};
+    for (const ShaderVertexInput &input : material.getShader(ShaderStage::Vertex, features)->reflection().vertexInputs)
+    {
+        if (input.location >= kVertexAttributeCount || input.scalar != ShaderScalarType::Float)
+        {
+            logMessage(2, logFormat("Vertex shader of material ", name, " reads location ", input.location, " which no vertex stream provides"), {"Graphics", "Vulkan", "Material"});
+            return VK_NULL_HANDLE;
+        }
+        const VertexAttribute &attribute = kVertexAttributes[input.location];
+        attributes.push_back({input.location, attribute.binding, attribute.format, attribute.offset});
+        bindingUsed[attribute.binding] = true;
+    }
+    std::vector<VkVertexInputBindingDescription> bindings;
+    if (bindingUsed[0])
+    {
+        bindings.push_back({0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX});
+    }
+    if (bindingUsed[1])
+    {
+        bindings.push_back({1, sizeof(InstanceTransform), VK_VERTEX_INPUT_RATE_INSTANCE});
+    }
+
+    VkPipelineVertexInputStateCreateInfo vertexInput{};
+    vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInput.vertexBindingDescriptionCount = static_cast<uint32_t>(bindings.size());
+    vertexInput.pVertexBindingDescriptions = bindings.data();
+    vertexInput.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributes.size());
+    vertexInput.pVertexAttributeDescriptions = attributes.data();
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPipelineViewportStateCreateInfo viewport{};
+    viewport.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewport.viewportCount = 1;
+    viewport.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterization{};
+    rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterization.cullMode = VK_CULL_MODE_BACK_BIT;
+    rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterization.lineWidth = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisample{};
+    multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = targets_.depthFormat != VK_FORMAT_UNDEFINED ? VK_TRUE : VK_FALSE;
+    depthStencil.depthWriteEnable = depthStencil.depthTestEnable;
+    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+    VkPipelineColorBlendAttachmentState blendAttachment{};
+    blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    VkPipelineColorBlendStateCreateInfo colorBlend{};
+    colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlend.attachmentCount = 1;
+    colorBlend.pAttachments = &blendAttachment;
+
+    VkDynamicState dynamicStates[2] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo dynamic{};
+    dynamic.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamic.dynamicStateCount = 2;
+    dynamic.pDynamicStates = dynamicStates;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = static_cast<uint32_t>(stages.size());
+    pipelineInfo.pStages = stages.data();
+    pipelineInfo.pVertexInputState = &vertexInput;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewport;
+    pipelineInfo.pRasterizationState = &rasterization;
+    pipelineInfo.pMultisampleState = &multisample;
+    pipelineInfo.pDepthStencilState = &depthStencil;
+    pipelineInfo.pColorBlendState = &colorBlend;
+    pipelineInfo.pDynamicState = &dynamic;
+    pipelineInfo.layout = layout.pipelineLayout;
+    pipelineInfo.renderPass = targets_.renderPass;
+    pipelineInfo.subpass = targets_.subpass;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkResult result = pipelineCache_.createGraphicsPipelines(1, &pipelineInfo, &pipeline);
+    if (result != VK_SUCCESS)
+    {
+        logMessage(2, logFormat("Failed to create graphics pipeline for material ", name, ". VkResult: ", result), {"Graphics", "Vulkan", "Material"});
+        return VK_NULL_HANDLE;
+    }
+    return pipeline;
+}
+
+VkPipeline VulkanPipelineBuilder::createComputePipeline(const Material &material, ShaderFeatureMask features, const std::string &name, VulkanMaterialLayout &layout)
+{
+    const ShaderHandle &shader = material.getShader(ShaderStage::Compute, features);
+    if (shader == nullptr)
+    {
+        logMessage(2, logFormat("Variant of material ", name, " for features ", features, " lacks its compute stage"), {"Graphics", "Vulkan", "Material"});
+        return VK_NULL_HANDLE;
+    }
+    const ShaderReflection &reflection = shader->reflection();
+    if (!reflection.valid)
+    {
+        return VK_NULL_HANDLE;
+    }
+    if (!layouts_.getLayout(reflection.bindings, reflection.pushConstantSize, true, layout))
+    {
+        logMessage(2, "Failed to derive pipeline layout for material: " + name, {"Graphics", "Vulkan", "Material"});
+        return VK_NULL_HANDLE;
+    }
+    VkShaderModule module = getShaderModule(shader);
+    if (module == VK_NULL_HANDLE)
+    {
+        return VK_NULL_HANDLE;
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    StageSpecialization specialization;
+    pipelineInfo.stage = stageInfo(VK_SHADER_STAGE_COMPUTE_BIT, module, shader, specialize(reflection, material, features, specialization));
+    pipelineInfo.layout = layout.pipelineLayout;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkResult result = pipelineCache_.createComputePipelines(1, &pipelineInfo, &pipeline);
+    if (result != VK_SUCCESS)
+    {
+        logMessage(2, logFormat("Failed to create compute pipeline for material ", name, ". VkResult: ", result), {"Graphics", "Vulkan", "Material"});
+        return VK_NULL_HANDLE;
+    }
+    return pipeline;
+}
+
+#endif // VULKAN_LINKED
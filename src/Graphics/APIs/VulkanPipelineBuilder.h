@@ -0,0 +1,147 @@
+#ifndef VULKANPIPELINEBUILDER_H
+#define VULKANPIPELINEBUILDER_H
+
+#ifdef VULKAN_LINKED
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "Graphics/Objects/Material.hpp"
+#include "Utils/ThreadPool.hpp"
+#include "VulkanLayoutCache.h"
+#include "VulkanPipelineCache.h"
+
+// builds shader modules and pipelines for materials on a worker pool
+//
+// every directory under SHADER_BINARY_DIR holding compiled stages (name.vertex.spv, ...)
+// is a material; build() maps its binaries through the ShaderRegistry, creates the
+// shader modules (one per distinct binary, shared between materials) and its graphics
+// and / or compute pipeline through the VulkanPipelineCache, all on a pool thread, and
+// hands back a future the renderer waits on once it needs the pipeline
+//
+// pipeline layouts come from the stages' reflection through a VulkanLayoutCache;
+// vertex inputs are bound only where the vertex shader reads them: locations 0-3 are
+// Vertex (binding 0) position, normal, texCoord and color, 4-6 the rows of the
+// InstanceTransform (binding 1, per instance); viewport and scissor are dynamic
+//
+// a material is built per feature mask (see Material): the mask picks the variant binary
+// for its compiled keys and sets the bool specialization constants named after the
+// others, so permutations that differ only in specialized keys share their shader modules
+
+// what graphics pipelines render into, a render pass compatible with this one is created
+// when none is given; pipelines work with any render pass compatible with it
+struct VulkanPipelineTargets
+{
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    uint32_t subpass = 0;
+    VkFormat colorFormat = VK_FORMAT_B8G8R8A8_SRGB;
+    VkFormat depthFormat = VK_FORMAT_D32_SFLOAT;
+};
+
+struct VulkanMaterialPipeline
+{
+    std::string name;  // material directory, relative to SHADER_BINARY_DIR
+    ShaderFeatureMask features = 0;
+    std::shared_ptr<const Material> material;
+    // shared with every material whose shaders declare the same resources
+    VulkanMaterialLayout graphicsLayout;
+    VulkanMaterialLayout computeLayout;
+    // null when the material has no stages for it or creation failed
+    VkPipeline graphics = VK_NULL_HANDLE;
+    VkPipeline compute = VK_NULL_HANDLE;
+
+    bool valid() const { return graphics != VK_NULL_HANDLE || compute != VK_NULL_HANDLE; }
+};
+
+using VulkanPipelineFuture = std::shared_future<VulkanMaterialPipeline>;
+
+// the permutations of one material built so far, indexed by feature mask, so resolving a
+// mask to its pipeline is one load from a fixed table without hashing or locking
+class VulkanMaterialPermutations
+{
+public:
+    const std::string &getName() const { return name_; }
+
+    // null while the permutation is building, when it failed or was never asked for
+    const VulkanMaterialPipeline *find(ShaderFeatureMask features) const
+    {
+        return features < kShaderPermutationCount ? pipelines_[features].load(std::memory_order_acquire) : nullptr;
+    }
+
+private:
+    friend class VulkanPipelineBuilder;
+
+    explicit VulkanMaterialPermutations(const std::string &name) : name_(name) {}
+
+    std::string name_;
+    // loaded by the first of its builds to run, the others wait on it
+    std::once_flag loaded_;
+    std::shared_ptr<const Material> material_;
+    // guarded by the builder's mutex
+    VulkanPipelineFuture builds_[kShaderPermutationCount];
+    // each slot written once, by the build of that mask, before it is published in pipelines_
+    std::unique_ptr<VulkanMaterialPipeline> built_[kShaderPermutationCount];
+    std::atomic<const VulkanMaterialPipeline *> pipelines_[kShaderPermutationCount] = {};
+};
+
+class VulkanPipelineBuilder
+{
+public:
+    VulkanPipelineBuilder(VkDevice device, VulkanPipelineCache &pipelineCache, const VulkanPipelineTargets &targets = {},
+                          ThreadPool &pool = ThreadPool::shared());
+    // waits for builds still running, then destroys everything it created
+    ~VulkanPipelineBuilder();
+
+    VulkanPipelineBuilder(const VulkanPipelineBuilder &) = delete;
+    VulkanPipelineBuilder &operator=(const VulkanPipelineBuilder &) = delete;
+
+    // directories below SHADER_BINARY_DIR that hold at least one .spv, relative and sorted
+    static std::vector<std::string> discoverMaterials();
+
+    // queues the build of one permutation of a material, each is built once; features are
+    // bits from the material's featureBit(), 0 for the material without any
+    VulkanPipelineFuture build(const std::string &material, ShaderFeatureMask features = 0);
+    // discoverMaterials() and build() for each of them, without features
+    std::vector<VulkanPipelineFuture> buildAll();
+
+    // the permutation table of a material, valid as long as the builder; renderers keep it
+    // to resolve feature masks per draw instead of looking the material up by name
+    const VulkanMaterialPermutations &getPermutations(const std::string &material);
+
+    // blocks until every queued build finished
+    void wait();
+
+    VkRenderPass getRenderPass() const { return targets_.renderPass; }
+    VulkanLayoutCache &getLayoutCache() { return layouts_; }
+
+private:
+    VkDevice device_;
+    VulkanPipelineCache &pipelineCache_;
+    VulkanPipelineTargets targets_;
+    ThreadPool &pool_;
+    bool ownsRenderPass_ = false;
+    VulkanLayoutCache layouts_;
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::unique_ptr<VulkanMaterialPermutations>> materials_;
+    // by ShaderBinary::hash, materials sharing a binary share its module
+    std::unordered_map<uint64_t, VkShaderModule> modules_;
+
+    bool createRenderPass();
+    // callers hold mutex_
+    VulkanMaterialPermutations &permutationsOf(const std::string &material);
+    VulkanMaterialPipeline buildMaterial(VulkanMaterialPermutations &permutations, ShaderFeatureMask features);
+    VkShaderModule getShaderModule(const ShaderHandle &shader);
+    VkPipeline createGraphicsPipeline(const Material &material, ShaderFeatureMask features, const std::string &name, VulkanMaterialLayout &layout);
+    VkPipeline createComputePipeline(const Material &material, ShaderFeatureMask features, const std::string &name, VulkanMaterialLayout &layout);
+};
+
+#endif // VULKAN_LINKED
+#endif // VULKANPIPELINEBUILDER_H
@@ -0,0 +1,295 @@
+#include "VulkanPipelineCache.h"
+
+#ifdef VULKAN_LINKED
+
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "Utils/Hash.hpp"
+#include "Utils/MappedFile.hpp"
+#include "Utils/Utils.hpp"
+
+namespace
+{
+    constexpr char kPipelineCacheMagic[8] = {'V', 'R', 'P', 'C', 'A', 'C', 'H', 'E'};
+    // bump whenever VulkanPipelineCacheFileHeader changes
+    constexpr uint32_t kPipelineCacheVersion = 1;
+
+    // the header every driver puts in front of vkGetPipelineCacheData, see VkPipelineCacheHeaderVersionOne
+    struct DriverCacheHeader
+    {
+        uint32_t headerSize;
+        uint32_t headerVersion;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+    };
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+VulkanPipelineCache::~VulkanPipelineCache()
+{
+    destroy();
+}
+
+bool VulkanPipelineCache::create(VkPhysicalDevice physicalDevice, VkDevice device, const std::string &cacheDirectory)
+{
+    destroy();
+    auto start = std::chrono::steady_clock::now();
+
+    device_ = device;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties_);
+    char fileName[48];
+    std::snprintf(fileName, sizeof(fileName), "vk_%04x_%04x.pipelines", properties_.vendorID, properties_.deviceID);
+    path_ = (std::filesystem::path(cacheDirectory) / fileName).string();
+
+    warmStart_ = false;
+    coldReason_.clear();
+    loadedBytes_ = 0;
+    loadedHash_ = 0;
+    pipelineCount_ = 0;
+    pipelineNanoseconds_ = 0;
+
+    MappedFile file;
+    const uint8_t *initialData = nullptr;
+    if (!file.openRead(path_))
+    {
+        coldReason_ = "no cache file";
+    }
+    else
+    {
+        initialData = validateFile(file, coldReason_);
+    }
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    if (initialData != nullptr)
+    {
+        createInfo.initialDataSize = file.size() - sizeof(VulkanPipelineCacheFileHeader);
+        createInfo.pInitialData = initialData;
+    }
+
+    VkResult result = vkCreatePipelineCache(device_, &createInfo, nullptr, &cache_);
+    if (result != VK_SUCCESS && initialData != nullptr)
+    {
+        // drivers may still refuse data they wrote themselves, an empty cache always works
+        logMessage(2, logFormat("Driver rejected the pipeline cache file, starting empty. VkResult: ", result), {"Graphics", "Vulkan"});
+        coldReason_ = "rejected by the driver";
+        initialData = nullptr;
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData = nullptr;
+        result = vkCreatePipelineCache(device_, &createInfo, nullptr, &cache_);
+    }
+    if (result != VK_SUCCESS)
+    {
+        logMessage(1, logFormat("Failed to create Vulkan pipeline cache. VkResult: ", result), {"Graphics", "Vulkan"});
+        cache_ = VK_NULL_HANDLE;
+        device_ = VK_NULL_HANDLE;
+        return false;
+    }
+
+    if (initialData != nullptr)
+    {
+        warmStart_ = true;
+        loadedBytes_ = createInfo.initialDataSize;
+        loadedHash_ = hashBytes(initialData, createInfo.initialDataSize);
+    }
+    loadMilliseconds_ = millisecondsSince(start);
+    logReport();
+    return true;
+}
+
+const uint8_t *VulkanPipelineCache::validateFile(const MappedFile &file, std::string &reason) const
+{
+    VulkanPipelineCacheFileHeader header;
+    if (file.size() < sizeof(header) + sizeof(DriverCacheHeader))
+    {
+        reason = "cache file truncated";
+        return nullptr;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, kPipelineCacheMagic, sizeof(kPipelineCacheMagic)) != 0 || header.version != kPipelineCacheVersion)
+    {
+        reason = "unknown cache file version";
+        return nullptr;
+    }
+    if (header.vendorID != properties_.vendorID || header.deviceID != properties_.deviceID)
+    {
+        reason = "written for another device";
+        return nullptr;
+    }
+    if (header.driverVersion != properties_.driverVersion)
+    {
+        reason = "written by another driver version";
+        return nullptr;
+    }
+    if (std::memcmp(header.pipelineCacheUUID, properties_.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+    {
+        reason = "pipeline cache UUID changed";
+        return nullptr;
+    }
+
+    const uint8_t *blob = file.data() + sizeof(header);
+    if (header.dataSize != file.size() - sizeof(header) || hashBytes(blob, header.dataSize) != header.dataHash)
+    {
+        reason = "cache file corrupt";
+        return nullptr;
+    }
+
+    // the driver checks its own header too, but some only crash on a mismatch
+    DriverCacheHeader driverHeader;
+    std::memcpy(&driverHeader, blob, sizeof(driverHeader));
+    if (driverHeader.headerSize < sizeof(driverHeader) || driverHeader.headerSize > header.dataSize ||
+        driverHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        driverHeader.vendorID != properties_.vendorID || driverHeader.deviceID != properties_.deviceID ||
+        std::memcmp(driverHeader.pipelineCacheUUID, properties_.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+    {
+        reason = "driver header mismatch";
+        return nullptr;
+    }
+    return blob;
+}
+
+bool VulkanPipelineCache::save()
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (cache_ == VK_NULL_HANDLE)
+    {
+        return false;
+    }
+
+    size_t dataSize = 0;
+    if (vkGetPipelineCacheData(device_, cache_, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0)
+    {
+        logMessage(2, "Failed to get Vulkan pipeline cache size.", {"Graphics", "Vulkan"});
+        return false;
+    }
+    std::vector<uint8_t> data(dataSize);
+    // VK_INCOMPLETE when pipelines were added since the size query, the prefix is still a valid cache
+    VkResult result = vkGetPipelineCacheData(device_, cache_, &dataSize, data.data());
+    if (result != VK_SUCCESS && result != VK_INCOMPLETE)
+    {
+        logMessage(2, logFormat("Failed to get Vulkan pipeline cache data. VkResult: ", result), {"Graphics", "Vulkan"});
+        return false;
+    }
+    data.resize(dataSize);
+
+    uint64_t dataHash = hashBytes(data.data(), data.size());
+    if (warmStart_ && data.size() == loadedBytes_ && dataHash == loadedHash_)
+    {
+        logMessage(4, "Vulkan pipeline cache unchanged, not rewritten.", {"Graphics", "Vulkan"});
+        return true;
+    }
+
+    VulkanPipelineCacheFileHeader header{};
+    std::memcpy(header.magic, kPipelineCacheMagic, sizeof(kPipelineCacheMagic));
+    header.version = kPipelineCacheVersion;
+    header.vendorID = properties_.vendorID;
+    header.deviceID = properties_.deviceID;
+    header.driverVersion = properties_.driverVersion;
+    std::memcpy(header.pipelineCacheUUID, properties_.pipelineCacheUUID, VK_UUID_SIZE);
+    header.dataSize = data.size();
+    header.dataHash = dataHash;
+
+    std::error_code error;
+    std::filesystem::path target(path_);
+    if (target.has_parent_path())
+    {
+        std::filesystem::create_directories(target.parent_path(), error);
+    }
+    // written next to the target and renamed over it, a crash mid write leaves the old file
+    std::string tempPath = path_ + ".tmp";
+    {
+        MappedFile file;
+        if (!file.create(tempPath, sizeof(header) + data.size()))
+        {
+            logMessage(2, "Failed to write Vulkan pipeline cache: " + tempPath, {"Graphics", "Vulkan"});
+            return false;
+        }
+        std::memcpy(file.data(), &header, sizeof(header));
+        std::memcpy(file.data() + sizeof(header), data.data(), data.size());
+    }
+    std::filesystem::rename(tempPath, target, error);
+    if (error)
+    {
+        std::filesystem::remove(tempPath, error);
+        logMessage(2, "Failed to replace Vulkan pipeline cache: " + path_, {"Graphics", "Vulkan"});
+        return false;
+    }
+    logMessage(3, logFormat("Saved Vulkan pipeline cache (", data.size(), " bytes) to ", path_), {"Graphics", "Vulkan"});
+    return true;
+}
+
+void VulkanPipelineCache::destroy()
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (cache_ != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineCache(device_, cache_, nullptr);
+        cache_ = VK_NULL_HANDLE;
+    }
+    device_ = VK_NULL_HANDLE;
+}
+
+template <typename CreateFn>
+VkResult VulkanPipelineCache::timedCreate(uint32_t count, CreateFn &&create)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (cache_ == VK_NULL_HANDLE)
+    {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    auto start = std::chrono::steady_clock::now();
+    VkResult result = create();
+    pipelineNanoseconds_ += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    pipelineCount_ += count;
+    return result;
+}
+
+VkResult VulkanPipelineCache::createGraphicsPipelines(uint32_t count, const VkGraphicsPipelineCreateInfo *createInfos, VkPipeline *pipelines)
+{
+    return timedCreate(count, [&]()
+    {
+        return vkCreateGraphicsPipelines(device_, cache_, count, createInfos, nullptr, pipelines);
+    });
+}
+
+VkResult VulkanPipelineCache::createComputePipelines(uint32_t count, const VkComputePipelineCreateInfo *createInfos, VkPipeline *pipelines)
+{
+    return timedCreate(count, [&]()
+    {
+        return vkCreateComputePipelines(device_, cache_, count, createInfos, nullptr, pipelines);
+    });
+}
+
+void VulkanPipelineCache::logReport() const
+{
+    std::ostringstream ss;
+    ss << "Vulkan pipeline cache (" << path_ << "):\n";
+    if (warmStart_)
+    {
+        ss << "  Start: warm, " << loadedBytes_ << " bytes loaded";
+    }
+    else
+    {
+        ss << "  Start: cold, " << coldReason_;
+    }
+    ss << " in " << std::fixed << std::setprecision(2) << loadMilliseconds_ << " ms\n";
+
+    uint64_t count = pipelineCount_;
+    double totalMilliseconds = static_cast<double>(pipelineNanoseconds_) / 1e6;
+    ss << "  Pipelines created: " << count << " in " << totalMilliseconds << " ms";
+    if (count != 0)
+    {
+        ss << " (" << totalMilliseconds / static_cast<double>(count) << " ms each)";
+    }
+    logMessage(3, ss.str(), {"Graphics", "Vulkan"});
+}
+
+#endif // VULKAN_LINKED
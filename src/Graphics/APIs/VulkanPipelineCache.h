@@ -0,0 +1,86 @@
+#ifndef VULKANPIPELINECACHE_H
+#define VULKANPIPELINECACHE_H
+
+#ifdef VULKAN_LINKED
+
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+
+#include <vulkan/vulkan.h>
+
+class MappedFile; // Forward declaration
+
+// VkPipelineCache that survives restarts
+//
+// create() seeds the cache from the file written by the last save(), the file is only
+// used when it was written for the same vendor, device, driver version and pipeline
+// cache UUID, anything else (new driver, other GPU, truncated file) starts empty
+// the driver synchronizes the cache internally, so any thread may create pipelines
+// through it at the same time; only destroy() needs them all finished
+
+// file layout: VulkanPipelineCacheFileHeader, then the vkGetPipelineCacheData blob
+struct VulkanPipelineCacheFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+    uint64_t dataSize;
+    uint64_t dataHash;  // hashBytes of the blob
+};
+
+class VulkanPipelineCache
+{
+public:
+    VulkanPipelineCache() = default;
+    ~VulkanPipelineCache();
+
+    VulkanPipelineCache(const VulkanPipelineCache &) = delete;
+    VulkanPipelineCache &operator=(const VulkanPipelineCache &) = delete;
+
+    // cacheDirectory/vk_<vendor>_<device>.pipelines is read now and written by save()
+    bool create(VkPhysicalDevice physicalDevice, VkDevice device, const std::string &cacheDirectory);
+    // writes the cache when it holds anything the loaded file did not
+    bool save();
+    // without saving, call save() first to keep the pipelines built this run
+    void destroy();
+
+    VkPipelineCache get() const { return cache_; }
+    bool isWarm() const { return warmStart_; }
+
+    // vkCreate*Pipelines through the cache, timed for the report
+    VkResult createGraphicsPipelines(uint32_t count, const VkGraphicsPipelineCreateInfo *createInfos, VkPipeline *pipelines);
+    VkResult createComputePipelines(uint32_t count, const VkComputePipelineCreateInfo *createInfos, VkPipeline *pipelines);
+
+    // how the cache was seeded and what pipeline creation cost so far
+    void logReport() const;
+
+private:
+    VkDevice device_ = VK_NULL_HANDLE;
+    VkPipelineCache cache_ = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties properties_{};
+    std::string path_;
+
+    // shared by pipeline creation and save, exclusive for destroy
+    mutable std::shared_mutex mutex_;
+
+    bool warmStart_ = false;
+    std::string coldReason_;
+    uint64_t loadedBytes_ = 0;
+    uint64_t loadedHash_ = 0;
+    double loadMilliseconds_ = 0.0;
+    std::atomic<uint64_t> pipelineCount_{0};
+    std::atomic<uint64_t> pipelineNanoseconds_{0};
+
+    // the blob inside file when it was written for this device and driver, else null and why
+    const uint8_t *validateFile(const MappedFile &file, std::string &reason) const;
+    template <typename CreateFn>
+    VkResult timedCreate(uint32_t count, CreateFn &&create);
+};
+
+#endif // VULKAN_LINKED
+#endif // VULKANPIPELINECACHE_H
@@ -0,0 +1,192 @@
+#include "Bounds.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BOUNDS_SSE2 1
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+#define BOUNDS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+    const glm::vec3* pointAt(const glm::vec3* points, size_t index, size_t stride) {
+        return reinterpret_cast<const glm::vec3*>(reinterpret_cast<const uint8_t*>(points) + index * stride);
+    }
+
+#if BOUNDS_SSE2
+    // x y z 0, reads exactly the three floats so the last point of an array is safe
+    __m128 loadPoint(const glm::vec3* point) {
+        const float* p = &point->x;
+        __m128 xy = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(p)));
+        return _mm_movelh_ps(xy, _mm_load_ss(p + 2));
+    }
+
+    glm::vec3 storePoint(__m128 value) {
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, value);
+        return glm::vec3(lanes[0], lanes[1], lanes[2]);
+    }
+#elif BOUNDS_NEON
+    float32x4_t loadPoint(const glm::vec3* point) {
+        const float* p = &point->x;
+        return vcombine_f32(vld1_f32(p), vset_lane_f32(p[2], vdup_n_f32(0.0f), 0));
+    }
+
+    glm::vec3 storePoint(float32x4_t value) {
+        float lanes[4];
+        vst1q_f32(lanes, value);
+        return glm::vec3(lanes[0], lanes[1], lanes[2]);
+    }
+#endif
+}
+
+Aabb computeAabb(const glm::vec3* points, size_t count, size_t stride) {
+    Aabb bounds;
+    if (count == 0) {
+        return bounds;
+    }
+#if BOUNDS_SSE2 || BOUNDS_NEON
+    // two accumulator pairs so consecutive min / max do not wait on each other
+    auto minimum0 = loadPoint(points), maximum0 = minimum0;
+    auto minimum1 = minimum0, maximum1 = minimum0;
+    size_t i = 1;
+    for (; i + 1 < count; i += 2) {
+        auto a = loadPoint(pointAt(points, i, stride));
+        auto b = loadPoint(pointAt(points, i + 1, stride));
+#if BOUNDS_SSE2
+        minimum0 = _mm_min_ps(minimum0, a);
+        maximum0 = _mm_max_ps(maximum0, a);
+        minimum1 = _mm_min_ps(minimum1, b);
+        maximum1 = _mm_max_ps(maximum1, b);
+#else
+        minimum0 = vminq_f32(minimum0, a);
+        maximum0 = vmaxq_f32(maximum0, a);
+        minimum1 = vminq_f32(minimum1, b);
+        maximum1 = vmaxq_f32(maximum1, b);
+#endif
+    }
+    if (i < count) {
+        auto a = loadPoint(pointAt(points, i, stride));
+#if BOUNDS_SSE2
+        minimum0 = _mm_min_ps(minimum0, a);
+        maximum0 = _mm_max_ps(maximum0, a);
+#else
+        minimum0 = vminq_f32(minimum0, a);
+        maximum0 = vmaxq_f32(maximum0, a);
+#endif
+    }
+#if BOUNDS_SSE2
+    bounds.minimum = storePoint(_mm_min_ps(minimum0, minimum1));
+    bounds.maximum = storePoint(_mm_max_ps(maximum0, maximum1));
+#else
+    bounds.minimum = storePoint(vminq_f32(minimum0, minimum1));
+    bounds.maximum = storePoint(vmaxq_f32(maximum0, maximum1));
+#endif
+#else
+    for (size_t i = 0; i < count; ++i) {
+        bounds.grow(*pointAt(points, i, stride));
+    }
+#endif
+    return bounds;
+}
+
+BoundingSphere computeBoundingSphere(const glm::vec3* points, size_t count, size_t stride, const Aabb& bounds) {
+    BoundingSphere sphere;
+    if (count == 0 || bounds.empty()) {
+        return sphere;
+    }
+    sphere.center = bounds.center();
+    float maxDistance = 0.0f;
+#if BOUNDS_SSE2
+    __m128 center = loadPoint(&sphere.center);
+    __m128 farthest = _mm_setzero_ps();
+    for (size_t i = 0; i < count; ++i) {
+        __m128 offset = _mm_sub_ps(loadPoint(pointAt(points, i, stride)), center);
+        __m128 squared = _mm_mul_ps(offset, offset);
+        // x + y + z in lane 0, lane 3 is zero
+        __m128 sum = _mm_add_ps(squared, _mm_shuffle_ps(squared, squared, _MM_SHUFFLE(2, 3, 0, 1)));
+        sum = _mm_add_ss(sum, _mm_movehl_ps(sum, sum));
+        farthest = _mm_max_ss(farthest, sum);
+    }
+    maxDistance = _mm_cvtss_f32(farthest);
+#elif BOUNDS_NEON
+    float32x4_t center = loadPoint(&sphere.center);
+    float farthest = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        float32x4_t offset = vsubq_f32(loadPoint(pointAt(points, i, stride)), center);
+        farthest = std::max(farthest, vaddvq_f32(vmulq_f32(offset, offset)));
+    }
+    maxDistance = farthest;
+#else
+    for (size_t i = 0; i < count; ++i) {
+        glm::vec3 offset = *pointAt(points, i, stride) - sphere.center;
+        maxDistance = std::max(maxDistance, glm::dot(offset, offset));
+    }
+#endif
+    sphere.radius = std::sqrt(maxDistance);
+    return sphere;
+}
+
+Aabb transformAabb(const Aabb& bounds, const glm::mat4& transform) {
+    if (bounds.empty()) {
+        return bounds;
+    }
+    // Arvo: the center moves with the matrix, the half extent through its absolute values
+    glm::vec3 center = bounds.center();
+    glm::vec3 halfExtent = bounds.extent() * 0.5f;
+    glm::vec3 newCenter, newHalfExtent;
+    for (int row = 0; row < 3; ++row) {
+        newCenter[row] = transform[3][row];
+        newHalfExtent[row] = 0.0f;
+        for (int column = 0; column < 3; ++column) {
+            newCenter[row] += transform[column][row] * center[column];
+            newHalfExtent[row] += std::fabs(transform[column][row]) * halfExtent[column];
+        }
+    }
+    Aabb result;
+    result.minimum = newCenter - newHalfExtent;
+    result.maximum = newCenter + newHalfExtent;
+    return result;
+}
+
+FrustumTest testAabb(const Frustum& frustum, const Aabb& bounds) {
+    glm::vec3 center = bounds.center();
+    glm::vec3 halfExtent = bounds.extent() * 0.5f;
+    FrustumTest result = FrustumTest::Inside;
+    for (const glm::vec4& plane : frustum.planes) {
+        float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+        float reach = std::fabs(plane.x) * halfExtent.x + std::fabs(plane.y) * halfExtent.y + std::fabs(plane.z) * halfExtent.z;
+        if (distance < -reach) {
+            return FrustumTest::Outside;
+        }
+        if (distance < reach) {
+            result = FrustumTest::Intersecting;
+        }
+    }
+    return result;
+}
+
+bool intersectRayAabb(const glm::vec3& origin, const glm::vec3& inverseDirection, const Aabb& bounds, float maxDistance, float& tNear) {
+    float enter = 0.0f;
+    float exit = maxDistance;
+    for (int axis = 0; axis < 3; ++axis) {
+        float t0 = (bounds.minimum[axis] - origin[axis]) * inverseDirection[axis];
+        float t1 = (bounds.maximum[axis] - origin[axis]) * inverseDirection[axis];
+        if (t0 > t1) {
+            std::swap(t0, t1);
+        }
+        // written so a nan (origin on a slab of a flat axis) leaves the range alone
+        enter = t0 > enter ? t0 : enter;
+        exit = t1 < exit ? t1 : exit;
+        if (enter > exit) {
+            return false;
+        }
+    }
+    tNear = enter;
+    return true;
+}
@@ -0,0 +1,62 @@
+#ifndef BOUNDS_HPP
+#define BOUNDS_HPP
+
+#include <cstddef>
+#include <cfloat>
+#include <glm/glm.hpp>
+
+#include "ObjectUtils.hpp"
+
+// axis aligned boxes and spheres for meshes, instances and the scene BVH
+// the point loops run four floats at a time with SSE2 or NEON when the target has them
+
+struct Aabb {
+    // default is the empty box, growing it by anything gives that thing's bounds
+    glm::vec3 minimum = glm::vec3(FLT_MAX);
+    glm::vec3 maximum = glm::vec3(-FLT_MAX);
+
+    bool empty() const { return minimum.x > maximum.x || minimum.y > maximum.y || minimum.z > maximum.z; }
+    glm::vec3 center() const { return (minimum + maximum) * 0.5f; }
+    glm::vec3 extent() const { return maximum - minimum; }
+    // half the surface area, all the SAH needs
+    float halfArea() const {
+        glm::vec3 size = extent();
+        return empty() ? 0.0f : size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+    void grow(const glm::vec3& point) {
+        minimum = glm::min(minimum, point);
+        maximum = glm::max(maximum, point);
+    }
+    void grow(const Aabb& other) {
+        minimum = glm::min(minimum, other.minimum);
+        maximum = glm::max(maximum, other.maximum);
+    }
+    bool operator==(const Aabb& other) const { return minimum == other.minimum && maximum == other.maximum; }
+};
+
+struct BoundingSphere {
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+};
+
+enum class FrustumTest {
+    Outside,
+    Intersecting,
+    Inside
+};
+
+// bounds of count points stride bytes apart (positions inside a vertex struct work)
+Aabb computeAabb(const glm::vec3* points, size_t count, size_t stride = sizeof(glm::vec3));
+// sphere around the box center that holds every point, tighter than the box's own sphere
+BoundingSphere computeBoundingSphere(const glm::vec3* points, size_t count, size_t stride, const Aabb& bounds);
+
+// box around the transformed box, for instance bounds from mesh bounds
+Aabb transformAabb(const Aabb& bounds, const glm::mat4& transform);
+
+FrustumTest testAabb(const Frustum& frustum, const Aabb& bounds);
+
+// slab test, inverseDirection is 1 / direction per axis (infinities are fine),
+// tNear is where the ray enters the box (0 when it starts inside)
+bool intersectRayAabb(const glm::vec3& origin, const glm::vec3& inverseDirection, const Aabb& bounds, float maxDistance, float& tNear);
+
+#endif // BOUNDS_HPP
@@ -1,5 +1,8 @@
 #include "Material.hpp"
 
+#include <algorithm>
+#include <set>
+
 Material::Material(std::string filePath, std::string name) : filePath(filePath), name(name) {
     if(loadFromPath(filePath)){
         logMessage(3, "Material loaded successfully from path: " + filePath, {"Graphics", "Material", "Slang"});
@@ -11,22 +14,45 @@ Material::Material(std::string filePath, std::string name) : filePath(filePath),
 }
 
 Material::~Material() {
-    if (vertexShaderCode != nullptr) {
-        delete vertexShaderCode;
-    }
-    if (fragmentShaderCode != nullptr) {
-        delete fragmentShaderCode;
-    }
-    if (computeShaderCode != nullptr) {
-        delete computeShaderCode;
-    }
-    if (geometryShaderCode != nullptr) {
-        delete geometryShaderCode;
-    }
     logMessage(3, "Material destroyed: " + name, {"Graphics", "Material", "Slang"});
 
 }
 
+namespace
+{
+    // name.stage.spv, or name.stage.KEY+KEY.spv for a variant; keys come back sorted so
+    // a variant is the same whichever order the file spelled them in
+    bool parseShaderFileName(const std::string &stem, size_t &stage, std::vector<std::string> &keys) {
+        size_t nameEnd = stem.find('.');
+        if (nameEnd == std::string::npos) {
+            return false;
+        }
+        size_t stageEnd = stem.find('.', nameEnd + 1);
+        std::string stageName = stem.substr(nameEnd + 1, stageEnd == std::string::npos ? std::string::npos : stageEnd - nameEnd - 1);
+        for (stage = 0; stage < static_cast<size_t>(ShaderStage::Count); ++stage) {
+            if (stageName == shaderStageName(static_cast<ShaderStage>(stage))) {
+                break;
+            }
+        }
+        if (stage == static_cast<size_t>(ShaderStage::Count)) {
+            return false;
+        }
+        keys.clear();
+        for (size_t begin = stageEnd; begin != std::string::npos && begin < stem.size();) {
+            size_t keyEnd = stem.find('+', begin + 1);
+            std::string key = stem.substr(begin + 1, keyEnd == std::string::npos ? std::string::npos : keyEnd - begin - 1);
+            if (key.empty() || key.find('.') != std::string::npos) {
+                return false;
+            }
+            keys.push_back(std::move(key));
+            begin = keyEnd;
+        }
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        return true;
+    }
+}
+
 bool Material::loadFromPath(const std::string &path, const std::string &extension) {
     // list files in the directory
     std::filesystem::path dirPath = std::filesystem::path(SHADER_BINARY_DIR) / path;
@@ -34,79 +60,105 @@ bool Material::loadFromPath(const std::string &path, const std::string &extensio
         logMessage(2, "Material path does not exist or is not a directory: " + path, {"Graphics", "Material", "Slang"});
         return false;
     }
-    int loadedShaderCount = 0;
+
+    struct LoadedFile {
+        size_t stage;
+        std::vector<std::string> keys;
+        ShaderHandle shader;
+    };
+    std::vector<LoadedFile> loaded;
+    std::set<std::string> compiledKeys;
     for (const auto &entry : std::filesystem::directory_iterator(dirPath)) {
         const auto &filePath = entry.path();
-        if (filePath.extension() == extension) {
-            if (filePath.filename().string().find(".vertex.") != std::string::npos) {
-                if (!loadFile(filePath.string(), vertexShaderCode, extension)) {
-                    logMessage(2, "Failed to load vertex shader file: " + filePath.string(), {"Graphics", "Material", "Slang"});
-                    return false;
-                }else{
-                    logMessage(3, "Loaded vertex shader file: " + filePath.string(), {"Graphics", "Material", "Slang"});
-                    loadedShaderCount++;
-                    vertexShaderLoaded = true;
-                }
-            } else if (filePath.filename().string().find(".fragment.") != std::string::npos) {
-                if (!loadFile(filePath.string(), fragmentShaderCode, extension)) {
-                    logMessage(2, "Failed to load fragment shader file: " + filePath.string(), {"Graphics", "Material", "Slang"});
-                    return false;
-                }else{
-                    logMessage(3, "Loaded fragment shader file: " + filePath.string(), {"Graphics", "Material", "Slang"});
-                    loadedShaderCount++;
-                    fragmentShaderLoaded = true;
-                }
-            } else if (filePath.filename().string().find(".geometry.") != std::string::npos) {
-                if (!loadFile(filePath.string(), geometryShaderCode, extension)) {
-                    logMessage(2, "Failed to load geometry shader file: " + filePath.string(), {"Graphics", "Material", "Slang"});
-                    return false;
-                }else{
-                    logMessage(3, "Loaded geometry shader file: " + filePath.string(), {"Graphics", "Material", "Slang"});
-                    loadedShaderCount++;
-                    geometryShaderLoaded = true;
-                }
-            } else if (filePath.filename().string().find(".compute.") != std::string::npos) {
-                if (!loadFile(filePath.string(), computeShaderCode, extension)) {
-                    logMessage(2, "Failed to load compute shader file: " + filePath.string(), {"Graphics", "Material", "Slang"});
-                    return false;
-                }else{
-                    logMessage(3, "Loaded compute shader file: " + filePath.string(), {"Graphics", "Material", "Slang"});
-                    loadedShaderCount++;
-                    computeShaderLoaded = true;
-                }
+        if (filePath.extension() != extension) {
+            continue;
+        }
+        LoadedFile file;
+        if (!parseShaderFileName(filePath.stem().string(), file.stage, file.keys)) {
+            continue;
+        }
+        std::string stageName = shaderStageName(static_cast<ShaderStage>(file.stage));
+        if (!loadFile(filePath.string(), file.shader, extension)) {
+            logMessage(2, "Failed to load " + stageName + " shader file: " + filePath.string(), {"Graphics", "Material", "Slang"});
+            return false;
+        }
+        logMessage(3, "Loaded " + stageName + " shader file: " + filePath.string(), {"Graphics", "Material", "Slang"});
+        compiledKeys.insert(file.keys.begin(), file.keys.end());
+        loaded.push_back(std::move(file));
+    }
+
+    // named bool specialization constants are the keys that need no variant binary
+    std::set<std::string> keys = compiledKeys;
+    for (const LoadedFile &file : loaded) {
+        for (const ShaderSpecConstant &constant : file.shader->reflection().specConstants) {
+            if (constant.boolean && !constant.name.empty()) {
+                keys.insert(constant.name);
             }
         }
     }
-    return loadedShaderCount > 0;
+    if (keys.size() > kMaxShaderFeatures) {
+        logMessage(2, logFormat("Material ", path, " declares ", keys.size(), " feature keys, at most ", kMaxShaderFeatures, " are supported"), {"Graphics", "Material", "Slang"});
+        return false;
+    }
+    features.assign(keys.begin(), keys.end());
+    for (const std::string &key : compiledKeys) {
+        compiledFeatures |= featureBit(key);
+    }
+
+    for (LoadedFile &file : loaded) {
+        ShaderFeatureMask mask = 0;
+        for (const std::string &key : file.keys) {
+            mask |= featureBit(key);
+        }
+        auto variant = std::find_if(variants.begin(), variants.end(), [mask](const Variant &candidate) { return candidate.features == mask; });
+        if (variant == variants.end()) {
+            variant = variants.insert(variants.end(), Variant());
+            variant->features = mask;
+        }
+        if (variant->shaders[file.stage] != nullptr) {
+            logMessage(3, "Replacing existing shader for file: " + file.shader->path(), {"Graphics", "Material", "Slang"});
+        }
+        variant->shaders[file.stage] = std::move(file.shader);
+    }
+    if (!features.empty()) {
+        logMessage(4, logFormat("Material ", path, " has ", features.size(), " feature keys and ", variants.size(), " compiled variants"), {"Graphics", "Material", "Slang"});
+    }
+    return !loaded.empty();
 }
 
-bool Material::loadFile(const std::string &filepath, std::vector<char>*& buffer, const std::string &extension) {
+const ShaderHandle &Material::getShader(ShaderStage stage, ShaderFeatureMask features) const {
+    static const ShaderHandle missing;
+    ShaderFeatureMask compiled = features & compiledFeatures;
+    for (const Variant &variant : variants) {
+        if (variant.features == compiled) {
+            return variant.shaders[static_cast<size_t>(stage)];
+        }
+    }
+    return missing;
+}
 
-    std::ifstream file(filepath, std::ios::ate | std::ios::binary);
+bool Material::hasVariant(ShaderFeatureMask features) const {
+    ShaderFeatureMask compiled = features & compiledFeatures;
+    return std::any_of(variants.begin(), variants.end(), [compiled](const Variant &variant) { return variant.features == compiled; });
+}
 
-    if (!file.is_open()) {
-        logMessage(2, "Failed to open " + extension + " file: " + filepath, {"Graphics", "Material", "Slang"});
-        return false;
+ShaderFeatureMask Material::featureBit(const std::string &key) const {
+    auto found = std::lower_bound(features.begin(), features.end(), key);
+    if (found == features.end() || *found != key) {
+        return 0;
     }
+    return ShaderFeatureMask(1) << (found - features.begin());
+}
 
-    size_t fileSize = (size_t)file.tellg();
-
-    if (fileSize == 0) {
-        logMessage(2, extension + " file is empty: " + filepath, {"Graphics", "Material", "Slang"});
-        file.close();
+bool Material::loadFile(const std::string &filepath, ShaderHandle &shader, const std::string &extension) {
+    ShaderHandle loaded = ShaderRegistry::shared().load(filepath);
+    if (!loaded) {
+        logMessage(2, "Failed to load " + extension + " file: " + filepath, {"Graphics", "Material", "Slang"});
         return false;
     }
-
-    if(buffer != nullptr){
-        // delete existing buffer
-        logMessage(3, "Deleting existing buffer for file: " + filepath, {"Graphics", "Material", "Slang"});
-        delete buffer;
+    if (shader != nullptr) {
+        logMessage(3, "Replacing existing shader for file: " + filepath, {"Graphics", "Material", "Slang"});
     }
-    buffer = new std::vector<char>(fileSize);
-
-    file.seekg(0);
-    file.read(buffer->data(), fileSize);
-    file.close();
-
+    shader = std::move(loaded);
     return true;
-}
\ No newline at end of file
+}
@@ -5,11 +5,21 @@
 #include <vector>
 #include <fstream>
 #include "Utils/Utils.hpp"
+#include "ShaderRegistry.hpp"
 
 #include <filesystem>
 
 #include <vulkan/vulkan.h>
 
+// feature keys of a material, bit i stands for getFeatures()[i]
+//
+// a key is either compiled, name.vertex.KEY.spv holds the stage built with -DKEY=1 (variants
+// are declared in name.permutations next to the .slang), or specialized, a bool
+// specialization constant named KEY that is set when the pipeline is created; specialized
+// keys need no extra binary
+using ShaderFeatureMask = uint32_t;
+constexpr size_t kMaxShaderFeatures = 8;
+constexpr size_t kShaderPermutationCount = size_t(1) << kMaxShaderFeatures;
 
 class Material{
 
@@ -17,23 +27,41 @@ public:
     Material(const std::string filePath, const std::string name = "UnnamedMaterial");
     ~Material();
 
+    // null for stages this material has no binary for, the stages without any feature
+    const ShaderHandle &getShader(ShaderStage stage) const { return variants[0].shaders[static_cast<size_t>(stage)]; }
+    bool hasShader(ShaderStage stage) const { return getShader(stage) != nullptr; }
+
+    // the binary of the variant compiled for the compiled keys in features, null when that
+    // variant was not compiled or lacks the stage
+    const ShaderHandle &getShader(ShaderStage stage, ShaderFeatureMask features) const;
+    // whether every compiled key in features has a variant, specialized keys always do
+    bool hasVariant(ShaderFeatureMask features) const;
+
+    const std::vector<std::string> &getFeatures() const { return features; }
+    // bit of a key, 0 for keys this material does not know
+    ShaderFeatureMask featureBit(const std::string &key) const;
+    ShaderFeatureMask featureMask() const { return static_cast<ShaderFeatureMask>((size_t(1) << features.size()) - 1); }
+    // keys selecting a variant binary, the rest are specialization constants
+    ShaderFeatureMask compiledMask() const { return compiledFeatures; }
+
 private:
+    struct Variant {
+        ShaderFeatureMask features = 0;
+        // shared through ShaderRegistry, materials using the same shader hold the same mapping
+        ShaderHandle shaders[static_cast<size_t>(ShaderStage::Count)];
+    };
+
     bool loadFromPath(const std::string &path, const std::string &extension = ".spv");
 
-    bool loadFile(const std::string &filepath, std::vector<char> *&buffer, const std::string &extension);
+    bool loadFile(const std::string &filepath, ShaderHandle &shader, const std::string &extension);
 
     std::string filePath;
     std::string name;
 
-    std::vector<char>* vertexShaderCode = nullptr;
-    std::vector<char>* fragmentShaderCode = nullptr;
-    std::vector<char>* computeShaderCode = nullptr;
-    std::vector<char>* geometryShaderCode = nullptr;
-
-    bool vertexShaderLoaded = false;
-    bool fragmentShaderLoaded = false;
-    bool computeShaderLoaded = false;
-    bool geometryShaderLoaded = false;
+    // variants[0] is the one without features, the others follow in load order
+    std::vector<Variant> variants = std::vector<Variant>(1);
+    std::vector<std::string> features;
+    ShaderFeatureMask compiledFeatures = 0;
 
     //VKShaderModule vertexShaderModule = VK_NULL_HANDLE;
     
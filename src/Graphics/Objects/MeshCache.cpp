@@ -0,0 +1,362 @@
+#include "MeshCache.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <system_error>
+#include <thread>
+
+#include "Utils/Hash.hpp"
+#include "Utils/MappedFile.hpp"
+
+namespace
+{
+    constexpr uint64_t kBlobAlignment = 16;
+
+    uint64_t alignBlob(uint64_t offset) {
+        return (offset + kBlobAlignment - 1) & ~(kBlobAlignment - 1);
+    }
+
+    uint64_t rotl(uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    // count is bounded by the file size first so the byte size cannot overflow
+    template <typename T>
+    bool blobFits(uint64_t offset, uint64_t count, uint64_t size) {
+        return count <= size / sizeof(T) && offset <= size - count * sizeof(T);
+    }
+
+    bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    // folds value into hash, order matters so renamed or reordered libraries change it
+    uint64_t combineHash(uint64_t hash, uint64_t value) {
+        return rotl(hash ^ (value * 0x9E3779B185EBCA87ull), 29) * 0xC2B2AE3D27D4EB4Full;
+    }
+
+    uint64_t hashMaterialLibrary(uint64_t hash, const std::string& materialDirectory, const char* name, size_t nameLength) {
+        hash = combineHash(hash, hashBytes(reinterpret_cast<const uint8_t*>(name), nameLength));
+        MappedFile library;
+        if (!library.openRead((std::filesystem::path(materialDirectory) / std::string(name, nameLength)).string())) {
+            // missing and empty libraries both hash as absent, creating one invalidates the cache
+            return combineHash(hash, ~0ull);
+        }
+        hash = combineHash(hash, library.size());
+        return combineHash(hash, hashBytes(library.data(), library.size()));
+    }
+
+    template <typename T>
+    void readBlob(const uint8_t* data, uint64_t offset, uint64_t count, std::vector<T>& out) {
+        out.resize(count);
+        if (count != 0) {
+            std::memcpy(out.data(), data + offset, count * sizeof(T));
+        }
+    }
+
+    // places a blob of items at the next aligned offset and moves end past it
+    template <typename T>
+    void placeBlob(const std::vector<T>& items, uint64_t& end, uint64_t& offset, uint64_t& count) {
+        offset = alignBlob(end);
+        count = items.size();
+        end = offset + count * sizeof(T);
+    }
+
+    template <typename T>
+    void writeBlob(uint8_t* data, uint64_t offset, const std::vector<T>& items) {
+        if (!items.empty()) {
+            std::memcpy(data + offset, items.data(), items.size() * sizeof(T));
+        }
+    }
+
+    void copyVec3(float* out, const glm::vec3& value) {
+        out[0] = value.x;
+        out[1] = value.y;
+        out[2] = value.z;
+    }
+
+    std::vector<uint8_t> encodeMaterials(const std::vector<ModelMaterial>& materials) {
+        std::vector<uint8_t> bytes;
+        for (const ModelMaterial& material : materials) {
+            const std::string* strings[5] = {&material.name, &material.diffuseTexture, &material.specularTexture, &material.normalTexture, &material.alphaTexture};
+            MeshCacheMaterial fixed{};
+            copyVec3(fixed.ambient, material.ambient);
+            copyVec3(fixed.diffuse, material.diffuse);
+            copyVec3(fixed.specular, material.specular);
+            copyVec3(fixed.emission, material.emission);
+            fixed.shininess = material.shininess;
+            fixed.dissolve = material.dissolve;
+            fixed.ior = material.ior;
+            fixed.illum = material.illum;
+            for (int i = 0; i < 5; ++i) {
+                fixed.stringBytes[i] = static_cast<uint32_t>(strings[i]->size());
+            }
+            const uint8_t* raw = reinterpret_cast<const uint8_t*>(&fixed);
+            bytes.insert(bytes.end(), raw, raw + sizeof(fixed));
+            for (const std::string* text : strings) {
+                bytes.insert(bytes.end(), text->begin(), text->end());
+            }
+        }
+        return bytes;
+    }
+
+    // false when the strings run past the blob
+    bool decodeMaterials(const uint8_t* data, uint64_t size, uint32_t count, std::vector<ModelMaterial>& materials) {
+        if (count > size / sizeof(MeshCacheMaterial)) {
+            return false;
+        }
+        materials.resize(count);
+        uint64_t offset = 0;
+        for (ModelMaterial& material : materials) {
+            MeshCacheMaterial fixed;
+            if (size - offset < sizeof(fixed)) {
+                return false;
+            }
+            std::memcpy(&fixed, data + offset, sizeof(fixed));
+            offset += sizeof(fixed);
+            material.ambient = glm::vec3(fixed.ambient[0], fixed.ambient[1], fixed.ambient[2]);
+            material.diffuse = glm::vec3(fixed.diffuse[0], fixed.diffuse[1], fixed.diffuse[2]);
+            material.specular = glm::vec3(fixed.specular[0], fixed.specular[1], fixed.specular[2]);
+            material.emission = glm::vec3(fixed.emission[0], fixed.emission[1], fixed.emission[2]);
+            material.shininess = fixed.shininess;
+            material.dissolve = fixed.dissolve;
+            material.ior = fixed.ior;
+            material.illum = fixed.illum;
+            std::string* strings[5] = {&material.name, &material.diffuseTexture, &material.specularTexture, &material.normalTexture, &material.alphaTexture};
+            for (int i = 0; i < 5; ++i) {
+                if (size - offset < fixed.stringBytes[i]) {
+                    return false;
+                }
+                strings[i]->assign(reinterpret_cast<const char*>(data + offset), fixed.stringBytes[i]);
+                offset += fixed.stringBytes[i];
+            }
+        }
+        return offset == size;
+    }
+
+    bool rangeFits(uint64_t offset, uint64_t count, size_t size) {
+        return offset <= size && count <= size - offset;
+    }
+
+    // the blobs fit the file but their contents index each other, a damaged cache of the
+    // right size must not send later stages out of bounds
+    bool meshConsistent(const Mesh& mesh, size_t materialCount) {
+        size_t vertexCount = mesh.vertices.size();
+        for (uint32_t index : mesh.indices) {
+            if (index >= vertexCount) {
+                return false;
+            }
+        }
+        for (const MeshLod& lod : mesh.lods) {
+            if (!rangeFits(lod.indexOffset, lod.indexCount, mesh.indices.size()) || !rangeFits(lod.submeshOffset, lod.submeshCount, mesh.submeshes.size())) {
+                return false;
+            }
+        }
+        for (const Submesh& submesh : mesh.submeshes) {
+            if (!rangeFits(submesh.indexOffset, submesh.indexCount, mesh.indices.size()) || submesh.material >= materialCount) {
+                return false;
+            }
+        }
+        for (const Meshlet& meshlet : mesh.meshlets) {
+            if (meshlet.vertexCount > kMeshletMaxVertices || meshlet.triangleCount > kMeshletMaxTriangles ||
+                !rangeFits(meshlet.vertexOffset, meshlet.vertexCount, mesh.meshletVertices.size()) ||
+                !rangeFits(meshlet.triangleOffset, uint64_t(meshlet.triangleCount) * 3, mesh.meshletTriangles.size()) || meshlet.material >= materialCount) {
+                return false;
+            }
+            for (uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+                if (mesh.meshletVertices[meshlet.vertexOffset + i] >= vertexCount) {
+                    return false;
+                }
+            }
+            for (uint32_t i = 0; i < meshlet.triangleCount * 3; ++i) {
+                if (mesh.meshletTriangles[meshlet.triangleOffset + i] >= meshlet.vertexCount) {
+                    return false;
+                }
+            }
+        }
+        return mesh.tangents.empty() || mesh.tangents.size() == vertexCount;
+    }
+}
+
+uint64_t MeshCache::hashSource(const uint8_t* data, size_t size, const std::string& materialDirectory) {
+    uint64_t hash = hashBytes(data, size);
+
+    // materials are cooked into the cache, so the libraries they come from are part of the key
+    const char* p = reinterpret_cast<const char*>(data);
+    const char* end = p + size;
+    while (p < end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        while (p < lineEnd && isSpace(*p)) {
+            ++p;
+        }
+        if (lineEnd - p > 6 && std::memcmp(p, "mtllib", 6) == 0 && isSpace(p[6])) {
+            // several libraries may be listed on one line
+            p += 6;
+            while (p < lineEnd) {
+                while (p < lineEnd && isSpace(*p)) {
+                    ++p;
+                }
+                const char* nameEnd = p;
+                while (nameEnd < lineEnd && !isSpace(*nameEnd)) {
+                    ++nameEnd;
+                }
+                if (nameEnd > p) {
+                    hash = hashMaterialLibrary(hash, materialDirectory, p, static_cast<size_t>(nameEnd - p));
+                }
+                p = nameEnd;
+            }
+        }
+        p = lineEnd + 1;
+    }
+    return hash;
+}
+
+std::string MeshCache::cachePathFor(const std::string& sourcePath, const std::string& cacheDirectory) {
+    std::filesystem::path source(sourcePath);
+    std::string key = source.lexically_normal().generic_string();
+    uint64_t pathHash = hashBytes(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+
+    char suffix[24];
+    std::snprintf(suffix, sizeof(suffix), "_%016llx", static_cast<unsigned long long>(pathHash));
+    return (std::filesystem::path(cacheDirectory) / (source.stem().string() + suffix + ".vrmesh")).string();
+}
+
+bool MeshCache::read(const std::string& cachePath, uint64_t sourceSize, uint64_t sourceHash, const MeshCacheSettings& settings, std::vector<Mesh>& meshes,
+                     std::vector<ModelMaterial>& materials) {
+    MappedFile file;
+    if (!file.openRead(cachePath)) {
+        return false;
+    }
+    const uint8_t* data = file.data();
+    uint64_t size = file.size();
+
+    MeshCacheHeader header;
+    if (size < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kMeshCacheMagic, sizeof(kMeshCacheMagic)) != 0 || header.version != kMeshCacheVersion ||
+        header.vertexStride != sizeof(Vertex) || !(header.settings == settings) || header.sourceSize != sourceSize || header.sourceHash != sourceHash) {
+        return false;
+    }
+    uint64_t tableEnd = sizeof(header) + static_cast<uint64_t>(header.meshCount) * sizeof(MeshCacheEntry);
+    if (tableEnd > size || !blobFits<uint8_t>(header.materialOffset, header.materialBytes, size)) {
+        return false;
+    }
+    std::vector<ModelMaterial> loadedMaterials;
+    if (!decodeMaterials(data + header.materialOffset, header.materialBytes, header.materialCount, loadedMaterials)) {
+        return false;
+    }
+
+    std::vector<MeshCacheEntry> entries(header.meshCount);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        std::memcpy(&entries[i], data + sizeof(header) + i * sizeof(MeshCacheEntry), sizeof(MeshCacheEntry));
+    }
+    for (const MeshCacheEntry& entry : entries) {
+        if (!blobFits<Vertex>(entry.vertexOffset, entry.vertexCount, size) || !blobFits<uint32_t>(entry.indexOffset, entry.indexCount, size) ||
+            !blobFits<MeshLod>(entry.lodOffset, entry.lodCount, size) || !blobFits<Submesh>(entry.submeshOffset, entry.submeshCount, size) ||
+            !blobFits<Meshlet>(entry.meshletOffset, entry.meshletCount, size) ||
+            !blobFits<uint32_t>(entry.meshletVertexOffset, entry.meshletVertexCount, size) ||
+            !blobFits<uint8_t>(entry.meshletTriangleOffset, entry.meshletTriangleCount, size) ||
+            !blobFits<glm::vec4>(entry.tangentOffset, entry.tangentCount, size)) {
+            return false;
+        }
+    }
+
+    // the copies below are where the mapped pages get faulted in
+    std::vector<Mesh> loaded(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const MeshCacheEntry& entry = entries[i];
+        readBlob(data, entry.vertexOffset, entry.vertexCount, loaded[i].vertices);
+        readBlob(data, entry.indexOffset, entry.indexCount, loaded[i].indices);
+        readBlob(data, entry.lodOffset, entry.lodCount, loaded[i].lods);
+        readBlob(data, entry.submeshOffset, entry.submeshCount, loaded[i].submeshes);
+        readBlob(data, entry.meshletOffset, entry.meshletCount, loaded[i].meshlets);
+        readBlob(data, entry.meshletVertexOffset, entry.meshletVertexCount, loaded[i].meshletVertices);
+        readBlob(data, entry.meshletTriangleOffset, entry.meshletTriangleCount, loaded[i].meshletTriangles);
+        readBlob(data, entry.tangentOffset, entry.tangentCount, loaded[i].tangents);
+        if (!meshConsistent(loaded[i], loadedMaterials.size())) {
+            return false;
+        }
+    }
+    meshes = std::move(loaded);
+    materials = std::move(loadedMaterials);
+    return true;
+}
+
+bool MeshCache::write(const std::string& cachePath, uint64_t sourceSize, uint64_t sourceHash, const MeshCacheSettings& settings, const std::vector<Mesh>& meshes,
+                      const std::vector<ModelMaterial>& materials) {
+    std::error_code error;
+    std::filesystem::path target(cachePath);
+    if (target.has_parent_path()) {
+        std::filesystem::create_directories(target.parent_path(), error);
+        if (error) {
+            return false;
+        }
+    }
+
+    MeshCacheHeader header{};
+    std::memcpy(header.magic, kMeshCacheMagic, sizeof(kMeshCacheMagic));
+    header.version = kMeshCacheVersion;
+    header.vertexStride = sizeof(Vertex);
+    header.sourceSize = sourceSize;
+    header.sourceHash = sourceHash;
+    header.meshCount = static_cast<uint32_t>(meshes.size());
+    header.settings = settings;
+
+    std::vector<MeshCacheEntry> entries(meshes.size());
+    uint64_t offset = sizeof(header) + entries.size() * sizeof(MeshCacheEntry);
+    std::vector<uint8_t> materialBytes = encodeMaterials(materials);
+    header.materialCount = static_cast<uint32_t>(materials.size());
+    placeBlob(materialBytes, offset, header.materialOffset, header.materialBytes);
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        const Mesh& mesh = meshes[i];
+        MeshCacheEntry& entry = entries[i];
+        placeBlob(mesh.vertices, offset, entry.vertexOffset, entry.vertexCount);
+        placeBlob(mesh.indices, offset, entry.indexOffset, entry.indexCount);
+        placeBlob(mesh.lods, offset, entry.lodOffset, entry.lodCount);
+        placeBlob(mesh.submeshes, offset, entry.submeshOffset, entry.submeshCount);
+        placeBlob(mesh.meshlets, offset, entry.meshletOffset, entry.meshletCount);
+        placeBlob(mesh.meshletVertices, offset, entry.meshletVertexOffset, entry.meshletVertexCount);
+        placeBlob(mesh.meshletTriangles, offset, entry.meshletTriangleOffset, entry.meshletTriangleCount);
+        placeBlob(mesh.tangents, offset, entry.tangentOffset, entry.tangentCount);
+    }
+
+    // unique per thread and time so two loads of the same model never share a temporary file
+    uint64_t tempId = std::hash<std::thread::id>{}(std::this_thread::get_id()) ^
+                      static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    std::string tempPath = cachePath + ".tmp" + std::to_string(tempId);
+    {
+        MappedFile file;
+        if (!file.create(tempPath, offset)) {
+            return false;
+        }
+        uint8_t* data = file.data();
+        std::memcpy(data, &header, sizeof(header));
+        writeBlob(data, header.materialOffset, materialBytes);
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            std::memcpy(data + sizeof(header) + i * sizeof(MeshCacheEntry), &entries[i], sizeof(MeshCacheEntry));
+            writeBlob(data, entries[i].vertexOffset, meshes[i].vertices);
+            writeBlob(data, entries[i].indexOffset, meshes[i].indices);
+            writeBlob(data, entries[i].lodOffset, meshes[i].lods);
+            writeBlob(data, entries[i].submeshOffset, meshes[i].submeshes);
+            writeBlob(data, entries[i].meshletOffset, meshes[i].meshlets);
+            writeBlob(data, entries[i].meshletVertexOffset, meshes[i].meshletVertices);
+            writeBlob(data, entries[i].meshletTriangleOffset, meshes[i].meshletTriangles);
+            writeBlob(data, entries[i].tangentOffset, meshes[i].tangents);
+        }
+    }
+
+    std::filesystem::rename(tempPath, target, error);
+    if (error) {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,100 @@
+#ifndef MESHCACHE_HPP
+#define MESHCACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Model.hpp"
+
+// cooked binary copy of a Model's meshes, written after an OBJ is parsed and
+// welded and memory mapped on the next load instead of parsing the text again
+//
+// layout (native endianness, blobs 16 byte aligned):
+//   MeshCacheHeader
+//   MeshCacheEntry[meshCount]
+//   material blob: per material a MeshCacheMaterial followed by its strings, packed
+//   per mesh: Vertex[vertexCount], uint32_t[indexCount], MeshLod[lodCount], Submesh[submeshCount],
+//             Meshlet[meshletCount], uint32_t[meshletVertexCount], uint8_t[meshletTriangleCount],
+//             glm::vec4[tangentCount]
+// a cache is fresh when version, vertex stride, build settings and the size and
+// content hash of the source OBJ, with its mtllib files folded in, all match and every index and range stays inside
+// its arrays, anything else is rebuilt from the OBJ
+
+inline constexpr char kMeshCacheMagic[8] = {'V', 'R', 'M', 'E', 'S', 'H', '\0', '\0'};
+// bump whenever the layout or the way meshes are built changes
+inline constexpr uint32_t kMeshCacheVersion = 6;
+
+// MeshCacheSettings::flags, the on / off ModelOptions that change the cooked data
+inline constexpr uint32_t kMeshCacheOptimized = 1u << 0;
+inline constexpr uint32_t kMeshCacheMeshlets = 1u << 1;
+inline constexpr uint32_t kMeshCacheMergedShapes = 1u << 2;
+inline constexpr uint32_t kMeshCacheNormals = 1u << 3;
+inline constexpr uint32_t kMeshCacheTangents = 1u << 4;
+
+struct MeshCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t vertexStride;  // sizeof(Vertex) when written
+    MeshCacheSettings settings;
+    uint64_t sourceSize;    // bytes of the source OBJ
+    uint64_t sourceHash;    // MeshCache::hashSource of the source OBJ
+    uint32_t meshCount;
+    uint32_t materialCount;
+    uint64_t materialOffset;
+    uint64_t materialBytes;
+};
+static_assert(sizeof(MeshCacheHeader) == 72, "MeshCacheHeader must stay 72 bytes");
+
+// fixed part of a ModelMaterial, the name and texture paths follow it in this order
+struct MeshCacheMaterial {
+    float ambient[3];
+    float diffuse[3];
+    float specular[3];
+    float emission[3];
+    float shininess;
+    float dissolve;
+    float ior;
+    int32_t illum;
+    uint32_t stringBytes[5];  // name, diffuse, specular, normal, alpha texture
+};
+
+struct MeshCacheEntry {
+    uint64_t vertexOffset;  // from the start of the file
+    uint64_t vertexCount;
+    uint64_t indexOffset;
+    uint64_t indexCount;
+    uint64_t lodOffset;
+    uint64_t lodCount;
+    uint64_t submeshOffset;
+    uint64_t submeshCount;
+    uint64_t meshletOffset;
+    uint64_t meshletCount;
+    uint64_t meshletVertexOffset;
+    uint64_t meshletVertexCount;
+    uint64_t meshletTriangleOffset;
+    uint64_t meshletTriangleCount;  // bytes
+    uint64_t tangentOffset;
+    uint64_t tangentCount;
+};
+
+class MeshCache {
+public:
+    // hashBytes of the OBJ text combined with the name, size and bytes of every mtllib file
+    // it lists, found in materialDirectory like the parsers do, a missing library hashes too
+    static uint64_t hashSource(const uint8_t* data, size_t size, const std::string& materialDirectory);
+
+    // cache file for sourcePath inside cacheDirectory, <stem>_<hash of the path>.vrmesh
+    static std::string cachePathFor(const std::string& sourcePath, const std::string& cacheDirectory);
+
+    // fills meshes and materials from cachePath, false when it is missing, damaged or stale
+    static bool read(const std::string& cachePath, uint64_t sourceSize, uint64_t sourceHash, const MeshCacheSettings& settings, std::vector<Mesh>& meshes,
+                     std::vector<ModelMaterial>& materials);
+
+    // writes to a temporary file and renames it over cachePath, so readers never see half a cache
+    static bool write(const std::string& cachePath, uint64_t sourceSize, uint64_t sourceHash, const MeshCacheSettings& settings, const std::vector<Mesh>& meshes,
+                      const std::vector<ModelMaterial>& materials);
+};
+
+#endif // MESHCACHE_HPP
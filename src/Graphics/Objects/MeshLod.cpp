@@ -0,0 +1,415 @@
+#include "MeshLod.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "MeshOptimizer.hpp"
+#include "VertexWeld.hpp"
+
+namespace
+{
+    // symmetric 4x4 plane quadric plus the summed weight, evaluates to the weighted
+    // mean squared distance from the accumulated planes
+    struct Quadric {
+        double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+        double b0 = 0, b1 = 0, b2 = 0;
+        double c = 0;
+        double weight = 0;
+
+        void addPlane(const glm::vec3& normal, double distance, double planeWeight) {
+            double x = normal.x, y = normal.y, z = normal.z;
+            a00 += planeWeight * x * x;
+            a01 += planeWeight * x * y;
+            a02 += planeWeight * x * z;
+            a11 += planeWeight * y * y;
+            a12 += planeWeight * y * z;
+            a22 += planeWeight * z * z;
+            b0 += planeWeight * x * distance;
+            b1 += planeWeight * y * distance;
+            b2 += planeWeight * z * distance;
+            c += planeWeight * distance * distance;
+            weight += planeWeight;
+        }
+
+        Quadric& operator+=(const Quadric& other) {
+            a00 += other.a00; a01 += other.a01; a02 += other.a02;
+            a11 += other.a11; a12 += other.a12; a22 += other.a22;
+            b0 += other.b0; b1 += other.b1; b2 += other.b2;
+            c += other.c;
+            weight += other.weight;
+            return *this;
+        }
+
+        double evaluate(const glm::vec3& point) const {
+            if (weight <= 0.0) {
+                return 0.0;
+            }
+            double x = point.x, y = point.y, z = point.z;
+            double error = a00 * x * x + a11 * y * y + a22 * z * z
+                         + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                         + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+            return std::max(error, 0.0) / weight;
+        }
+    };
+
+    struct Collapse {
+        double cost;
+        uint32_t from;
+        uint32_t to;
+    };
+
+    // compressed lists, items of key k are items[offsets[k] .. offsets[k + 1])
+    struct Adjacency {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> items;
+    };
+
+    // triangles touching each position group
+    void buildGroupTriangles(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& group, size_t groupCount, Adjacency& adjacency) {
+        adjacency.offsets.assign(groupCount + 1, 0);
+        for (uint32_t index : indices) {
+            ++adjacency.offsets[group[index] + 1];
+        }
+        for (size_t g = 0; g < groupCount; ++g) {
+            adjacency.offsets[g + 1] += adjacency.offsets[g];
+        }
+        adjacency.items.resize(indices.size());
+        std::vector<uint32_t> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            adjacency.items[fill[group[indices[i]]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    glm::vec3 triangleNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+        return glm::cross(b - a, c - a);
+    }
+
+    // vertex of targetGroup whose normal, uv and color are nearest to vertex's
+    uint32_t closestAttributes(const std::vector<Vertex>& vertices, uint32_t vertex, const Adjacency& groupVertices, uint32_t targetGroup) {
+        const Vertex& source = vertices[vertex];
+        uint32_t best = groupVertices.items[groupVertices.offsets[targetGroup]];
+        float bestDistance = -1.0f;
+        for (uint32_t i = groupVertices.offsets[targetGroup]; i < groupVertices.offsets[targetGroup + 1]; ++i) {
+            const Vertex& candidate = vertices[groupVertices.items[i]];
+            glm::vec3 normal = candidate.normal - source.normal;
+            glm::vec2 texCoord = candidate.texCoord - source.texCoord;
+            glm::vec3 color = candidate.color - source.color;
+            float distance = glm::dot(normal, normal) + glm::dot(texCoord, texCoord) + glm::dot(color, color);
+            if (bestDistance < 0.0f || distance < bestDistance) {
+                bestDistance = distance;
+                best = groupVertices.items[i];
+            }
+        }
+        return best;
+    }
+}
+
+float simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount,
+                   float maxError, std::vector<uint32_t>& out, bool keepSeams) {
+    out = indices;
+    if (indices.size() <= targetIndexCount || vertices.empty()) {
+        return 0.0f;
+    }
+
+    // vertices sharing a position move together, seams are vertices of one group
+    std::vector<glm::vec3> groupPosition;
+    // only vertices the indices use, a material range of a large mesh stays cheap
+    std::vector<uint32_t> group(vertices.size(), UINT32_MAX);
+    {
+        VertexWeldTable<glm::vec3> positions(groupPosition, std::min(vertices.size(), indices.size()) / 2);
+        for (uint32_t index : indices) {
+            if (group[index] == UINT32_MAX) {
+                group[index] = positions.weld(vertices[index].position);
+            }
+        }
+    }
+    size_t groupCount = groupPosition.size();
+
+    // vertices of each group, for picking a partner across a seam when keepSeams is off
+    Adjacency groupVertices;
+    if (!keepSeams) {
+        groupVertices.offsets.assign(groupCount + 1, 0);
+        for (uint32_t g : group) {
+            if (g != UINT32_MAX) {
+                ++groupVertices.offsets[g + 1];
+            }
+        }
+        for (size_t g = 0; g < groupCount; ++g) {
+            groupVertices.offsets[g + 1] += groupVertices.offsets[g];
+        }
+        groupVertices.items.resize(groupVertices.offsets[groupCount]);
+        std::vector<uint32_t> fill(groupVertices.offsets.begin(), groupVertices.offsets.end() - 1);
+        for (size_t v = 0; v < vertices.size(); ++v) {
+            if (group[v] != UINT32_MAX) {
+                groupVertices.items[fill[group[v]]++] = static_cast<uint32_t>(v);
+            }
+        }
+    }
+
+    std::vector<Quadric> quadrics(groupCount);
+    for (size_t t = 0; t + 2 < out.size(); t += 3) {
+        const glm::vec3& a = vertices[out[t]].position;
+        const glm::vec3& b = vertices[out[t + 1]].position;
+        const glm::vec3& c = vertices[out[t + 2]].position;
+        glm::vec3 normal = triangleNormal(a, b, c);
+        float area = glm::length(normal);
+        if (area <= 0.0f) {
+            continue;
+        }
+        normal /= area;
+        double distance = -glm::dot(normal, a);
+        for (int k = 0; k < 3; ++k) {
+            quadrics[group[out[t + k]]].addPlane(normal, distance, area);
+        }
+    }
+
+    double maxCost = static_cast<double>(maxError) * maxError;
+    double reachedCost = 0.0;
+    Adjacency groupTriangles;
+    std::vector<uint64_t> edges;
+    std::vector<Collapse> collapses;
+    std::vector<uint8_t> locked(groupCount);
+    std::vector<uint8_t> dirty(groupCount);
+    std::vector<uint32_t> remap(vertices.size());
+    std::vector<uint32_t> seamTarget(vertices.size(), UINT32_MAX);
+    std::vector<uint32_t> seamVertices;
+
+    // each pass collapses an independent set of the cheapest edges, then rebuilds the topology
+    while (out.size() > targetIndexCount) {
+        size_t triangleCount = out.size() / 3;
+        buildGroupTriangles(out, group, groupCount, groupTriangles);
+
+        // edges used by one triangle are borders, by more than two non manifold, both stay put
+        edges.clear();
+        for (size_t t = 0; t < triangleCount; ++t) {
+            for (int k = 0; k < 3; ++k) {
+                uint64_t a = group[out[t * 3 + k]];
+                uint64_t b = group[out[t * 3 + (k + 1) % 3]];
+                if (a != b) {
+                    edges.push_back(a < b ? (a << 32) | b : (b << 32) | a);
+                }
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        std::fill(locked.begin(), locked.end(), 0);
+        collapses.clear();
+        for (size_t i = 0; i < edges.size();) {
+            size_t j = i + 1;
+            while (j < edges.size() && edges[j] == edges[i]) {
+                ++j;
+            }
+            uint32_t a = static_cast<uint32_t>(edges[i] >> 32);
+            uint32_t b = static_cast<uint32_t>(edges[i] & 0xffffffffu);
+            if (j - i != 2) {
+                locked[a] = locked[b] = 1;
+            } else {
+                collapses.push_back(Collapse{0.0, a, b});
+            }
+            i = j;
+        }
+
+        // cheaper direction of each edge, a direction whose source is locked is not an option
+        size_t candidateCount = 0;
+        for (const Collapse& edge : collapses) {
+            double forward = locked[edge.from] ? -1.0 : quadrics[edge.from].evaluate(groupPosition[edge.to]);
+            double backward = locked[edge.to] ? -1.0 : quadrics[edge.to].evaluate(groupPosition[edge.from]);
+            if (forward < 0.0 && backward < 0.0) {
+                continue;
+            }
+            if (backward >= 0.0 && (forward < 0.0 || backward < forward)) {
+                collapses[candidateCount++] = Collapse{backward, edge.to, edge.from};
+            } else {
+                collapses[candidateCount++] = Collapse{forward, edge.from, edge.to};
+            }
+        }
+        collapses.resize(candidateCount);
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        std::fill(dirty.begin(), dirty.end(), 0);
+        for (size_t v = 0; v < remap.size(); ++v) {
+            remap[v] = static_cast<uint32_t>(v);
+        }
+        size_t trianglesLeft = triangleCount;
+        size_t applied = 0;
+        for (const Collapse& collapse : collapses) {
+            if (collapse.cost > maxCost || trianglesLeft * 3 <= targetIndexCount) {
+                break;
+            }
+            if (dirty[collapse.from] || dirty[collapse.to]) {
+                continue;
+            }
+
+            // every vertex at the source needs a partner at the target on one of its own edges,
+            // otherwise the collapse would tear a seam, and no remaining triangle may flip
+            bool valid = true;
+            size_t removed = 0;
+            seamVertices.clear();
+            const glm::vec3& target = groupPosition[collapse.to];
+            for (uint32_t i = groupTriangles.offsets[collapse.from]; i < groupTriangles.offsets[collapse.from + 1] && valid; ++i) {
+                const uint32_t* corner = &out[groupTriangles.items[i] * 3];
+                int source = 0, partner = -1;
+                for (int k = 0; k < 3; ++k) {
+                    if (group[corner[k]] == collapse.from) {
+                        source = k;
+                    } else if (group[corner[k]] == collapse.to) {
+                        partner = k;
+                    }
+                }
+                uint32_t vertex = corner[source];
+                if (seamTarget[vertex] == UINT32_MAX) {
+                    seamVertices.push_back(vertex);
+                    seamTarget[vertex] = UINT32_MAX - 1;
+                }
+                if (partner >= 0) {
+                    ++removed;
+                    if (seamTarget[vertex] == UINT32_MAX - 1) {
+                        seamTarget[vertex] = corner[partner];
+                    }
+                    continue;
+                }
+                glm::vec3 p[3] = {vertices[corner[0]].position, vertices[corner[1]].position, vertices[corner[2]].position};
+                glm::vec3 before = triangleNormal(p[0], p[1], p[2]);
+                p[source] = target;
+                glm::vec3 after = triangleNormal(p[0], p[1], p[2]);
+                if (glm::dot(before, after) <= 0.0f) {
+                    valid = false;
+                }
+            }
+            for (uint32_t vertex : seamVertices) {
+                if (seamTarget[vertex] < UINT32_MAX - 1) {
+                    continue;
+                }
+                if (keepSeams) {
+                    valid = false;
+                    continue;
+                }
+                seamTarget[vertex] = closestAttributes(vertices, vertex, groupVertices, collapse.to);
+            }
+            if (valid) {
+                for (uint32_t vertex : seamVertices) {
+                    remap[vertex] = seamTarget[vertex];
+                }
+                quadrics[collapse.to] += quadrics[collapse.from];
+                for (uint32_t i = groupTriangles.offsets[collapse.from]; i < groupTriangles.offsets[collapse.from + 1]; ++i) {
+                    const uint32_t* corner = &out[groupTriangles.items[i] * 3];
+                    dirty[group[corner[0]]] = dirty[group[corner[1]]] = dirty[group[corner[2]]] = 1;
+                }
+                trianglesLeft -= removed;
+                reachedCost = std::max(reachedCost, collapse.cost);
+                ++applied;
+            }
+            for (uint32_t vertex : seamVertices) {
+                seamTarget[vertex] = UINT32_MAX;
+            }
+        }
+        if (applied == 0) {
+            break;
+        }
+
+        // targets are dirty so they were never remapped themselves, one lookup is enough
+        size_t written = 0;
+        for (size_t t = 0; t < triangleCount; ++t) {
+            uint32_t a = remap[out[t * 3]], b = remap[out[t * 3 + 1]], c = remap[out[t * 3 + 2]];
+            if (group[a] == group[b] || group[b] == group[c] || group[a] == group[c]) {
+                continue;
+            }
+            out[written++] = a;
+            out[written++] = b;
+            out[written++] = c;
+        }
+        out.resize(written);
+    }
+    return static_cast<float>(std::sqrt(reachedCost));
+}
+
+void generateLods(Mesh& mesh, unsigned int levels, float reduction, float maxError) {
+    // levels from an earlier call are dropped, a mesh without material ranges is one range
+    if (!mesh.lods.empty()) {
+        mesh.indices.resize(mesh.lods[0].indexCount);
+        mesh.submeshes.resize(mesh.lods[0].submeshCount);
+    }
+    if (mesh.submeshes.empty() && !mesh.indices.empty()) {
+        mesh.submeshes.push_back(Submesh{0, static_cast<uint32_t>(mesh.indices.size()), 0});
+    }
+    mesh.lods.clear();
+    mesh.lods.push_back(MeshLod{0, static_cast<uint32_t>(mesh.indices.size()), 0.0f, 0, static_cast<uint32_t>(mesh.submeshes.size())});
+    if (levels == 0 || mesh.vertices.empty()) {
+        return;
+    }
+
+    glm::vec3 minimum = mesh.vertices[0].position, maximum = minimum;
+    for (const Vertex& vertex : mesh.vertices) {
+        minimum = glm::min(minimum, vertex.position);
+        maximum = glm::max(maximum, vertex.position);
+    }
+    float maxDistance = maxError * 0.5f * glm::length(maximum - minimum);
+
+    // each level starts from the previous one, its error bound adds on top
+    // material ranges are simplified one by one, so the edges between two materials are
+    // open borders of both and stay put, the level error is the largest range error
+    std::vector<uint32_t> range, simplified, levelIndices;
+    std::vector<Submesh> levelSubmeshes;
+    for (unsigned int level = 1; level <= levels; ++level) {
+        const MeshLod previous = mesh.lods.back();
+        if (static_cast<size_t>(previous.indexCount / 3 * reduction) < 1 || previous.error >= maxDistance) {
+            break;
+        }
+        levelIndices.clear();
+        levelSubmeshes.clear();
+        float levelError = 0.0f;
+        for (uint32_t s = previous.submeshOffset; s < previous.submeshOffset + previous.submeshCount; ++s) {
+            const Submesh submesh = mesh.submeshes[s];
+            range.assign(mesh.indices.begin() + submesh.indexOffset, mesh.indices.begin() + submesh.indexOffset + submesh.indexCount);
+            size_t target = static_cast<size_t>(range.size() / 3 * reduction) * 3;
+            // seams are kept when that still reaches the target, meshes split along most edges
+            // (per face uvs, flat normals) only simplify when attributes may snap across them
+            // ranges down to a triangle or two are carried over whole
+            float error = 0.0f;
+            if (target < 3) {
+                simplified = range;
+            } else {
+                error = simplifyMesh(mesh.vertices, range, target, maxDistance - previous.error, simplified, true);
+            }
+            if (target >= 3 && simplified.size() * 4 > target * 5) {
+                error = simplifyMesh(mesh.vertices, range, target, maxDistance - previous.error, simplified, false);
+            }
+            if (simplified.empty()) {
+                continue;
+            }
+            optimizeVertexCache(simplified, mesh.vertices.size());
+            levelSubmeshes.push_back(Submesh{static_cast<uint32_t>(levelIndices.size()), static_cast<uint32_t>(simplified.size()), submesh.material});
+            levelIndices.insert(levelIndices.end(), simplified.begin(), simplified.end());
+            levelError = std::max(levelError, error);
+        }
+        // a level that barely drops anything is not worth an index range
+        if (levelIndices.empty() || levelIndices.size() * 20 > size_t(previous.indexCount) * 19) {
+            break;
+        }
+
+        MeshLod lod{static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(levelIndices.size()), previous.error + levelError,
+                    static_cast<uint32_t>(mesh.submeshes.size()), static_cast<uint32_t>(levelSubmeshes.size())};
+        for (Submesh& submesh : levelSubmeshes) {
+            submesh.indexOffset += lod.indexOffset;
+            mesh.submeshes.push_back(submesh);
+        }
+        mesh.indices.insert(mesh.indices.end(), levelIndices.begin(), levelIndices.end());
+        mesh.lods.push_back(lod);
+    }
+}
+
+float lodProjectionScale(float fovY, float viewportHeight) {
+    return viewportHeight / (2.0f * std::tan(fovY * 0.5f));
+}
+
+size_t selectLod(const Mesh& mesh, float distance, float projectionScale, float maxPixelError) {
+    if (mesh.lods.empty()) {
+        return 0;
+    }
+    float pixelsPerUnit = projectionScale / std::max(distance, 1e-6f);
+    for (size_t level = mesh.lods.size() - 1; level > 0; --level) {
+        if (mesh.lods[level].error * pixelsPerUnit <= maxPixelError) {
+            return level;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,39 @@
+#ifndef MESHLOD_HPP
+#define MESHLOD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Model.hpp"
+
+// quadric error metric simplification and the LOD chain built from it
+//
+// simplification collapses one vertex position onto a neighbouring one (half edge
+// collapse), so every level reuses the mesh's vertex buffer and only adds an index range
+// positions on open borders never move and every vertex sharing a position moves with
+// it, so no cracks open up; with keepSeams positions split by a uv / normal seam only
+// collapse along the seam, otherwise vertices snap to the closest attributes at the target
+// errors are object space distances, scale them with the instance transform
+
+// writes a simplified copy of indices to out aiming for targetIndexCount indices without
+// exceeding maxError, returns the error reached
+float simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount,
+                   float maxError, std::vector<uint32_t>& out, bool keepSeams = true);
+
+// appends up to levels coarser index ranges to mesh.indices, each with about reduction times
+// the triangles of the one before, and fills mesh.lods (lods[0] is always the full mesh)
+// a level that misses its target by more than a quarter with seams kept is rebuilt without
+// maxError is relative to the mesh bounds radius, the chain stops once a level would exceed it
+// each of mesh.submeshes is simplified on its own, every level gets its own material ranges
+void generateLods(Mesh& mesh, unsigned int levels, float reduction, float maxError);
+
+// pixels per object space unit at distance 1, viewportHeight / (2 tan(fovY / 2))
+// for stereo use the per eye viewport and fov
+float lodProjectionScale(float fovY, float viewportHeight);
+
+// coarsest level whose error projects to at most maxPixelError pixels at distance
+// (distance to the closest eye in VR so both eyes agree)
+size_t selectLod(const Mesh& mesh, float distance, float projectionScale, float maxPixelError = 1.0f);
+
+#endif // MESHLOD_HPP
@@ -0,0 +1,321 @@
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // FIFO post transform cache, an entry is live while fewer than size misses happened since it was loaded
+    struct FifoCache {
+        std::vector<uint32_t> loadedAt;
+        uint32_t time;
+        uint32_t size;
+
+        FifoCache(size_t vertexCount, unsigned int cacheSize) : loadedAt(vertexCount, 0), time(cacheSize + 1), size(cacheSize) {}
+
+        // returns true on a miss
+        bool access(uint32_t vertex) {
+            if (time - loadedAt[vertex] > size) {
+                loadedAt[vertex] = time++;
+                return true;
+            }
+            return false;
+        }
+
+        void flush() {
+            time += size + 1;
+        }
+    };
+
+    constexpr int kForsythCacheSize = 32;
+    constexpr unsigned int kForsythMaxValence = 32;
+
+    struct ForsythScores {
+        float cache[kForsythCacheSize];
+        float valence[kForsythMaxValence + 1];
+
+        ForsythScores() {
+            for (int i = 0; i < kForsythCacheSize; ++i) {
+                // the last triangle's three vertices get a fixed score so it is not reused right away
+                cache[i] = i < 3 ? 0.75f : std::pow(1.0f - float(i - 3) / float(kForsythCacheSize - 3), 1.5f);
+            }
+            valence[0] = 0.0f;
+            for (unsigned int i = 1; i <= kForsythMaxValence; ++i) {
+                valence[i] = 2.0f / std::sqrt(float(i));
+            }
+        }
+
+        float vertex(int cachePosition, uint32_t remainingTriangles) const {
+            if (remainingTriangles == 0) {
+                return -1.0f;
+            }
+            float score = cachePosition >= 0 ? cache[cachePosition] : 0.0f;
+            score += remainingTriangles <= kForsythMaxValence ? valence[remainingTriangles] : 2.0f / std::sqrt(float(remainingTriangles));
+            return score;
+        }
+    };
+}
+
+VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, unsigned int cacheSize) {
+    VertexCacheStats stats;
+    if (indices.empty() || vertexCount == 0) {
+        return stats;
+    }
+    FifoCache cache(vertexCount, cacheSize);
+    size_t misses = 0;
+    for (uint32_t index : indices) {
+        misses += cache.access(index) ? 1 : 0;
+    }
+    stats.acmr = float(misses) / float(indices.size() / 3);
+    stats.atvr = float(misses) / float(vertexCount);
+    return stats;
+}
+
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2 || vertexCount == 0) {
+        return;
+    }
+    static const ForsythScores scores;
+
+    // vertex to triangle adjacency, the first liveTriangles entries of each range are not emitted yet
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        ++liveTriangles[indices[i]];
+    }
+    std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + liveTriangles[v];
+    }
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for (size_t t = 0; t < triangleCount; ++t) {
+            for (int k = 0; k < 3; ++k) {
+                adjacency[fill[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+            }
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        vertexScore[v] = scores.vertex(-1, liveTriangles[v]);
+    }
+    std::vector<float> triangleScore(triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+    }
+    std::vector<bool> emitted(triangleCount, false);
+
+    std::vector<uint32_t> result;
+    result.reserve(triangleCount * 3);
+    uint32_t cache[kForsythCacheSize + 3];
+    size_t cacheCount = 0;
+    size_t scanPosition = 0;
+    int64_t best = 0;
+
+    for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+        if (best < 0) {
+            // nothing in the cache has triangles left, restart at the next triangle in input order
+            while (emitted[scanPosition]) {
+                ++scanPosition;
+            }
+            best = static_cast<int64_t>(scanPosition);
+        }
+        size_t triangle = static_cast<size_t>(best);
+        const uint32_t* corners = &indices[triangle * 3];
+        result.insert(result.end(), corners, corners + 3);
+        emitted[triangle] = true;
+
+        for (int k = 0; k < 3; ++k) {
+            uint32_t v = corners[k];
+            uint32_t* begin = &adjacency[adjacencyOffset[v]];
+            uint32_t* end = begin + liveTriangles[v];
+            uint32_t* found = std::find(begin, end, static_cast<uint32_t>(triangle));
+            if (found != end) {
+                std::swap(*found, *(end - 1));
+                --liveTriangles[v];
+            }
+        }
+
+        // the emitted vertices move to the front, the rest shift back and may fall out
+        uint32_t updated[kForsythCacheSize + 3];
+        size_t updatedCount = 0;
+        for (int k = 0; k < 3; ++k) {
+            if (std::find(updated, updated + updatedCount, corners[k]) == updated + updatedCount) {
+                updated[updatedCount++] = corners[k];
+            }
+        }
+        for (size_t i = 0; i < cacheCount; ++i) {
+            if (cache[i] != corners[0] && cache[i] != corners[1] && cache[i] != corners[2]) {
+                updated[updatedCount++] = cache[i];
+            }
+        }
+
+        for (size_t i = 0; i < updatedCount; ++i) {
+            uint32_t v = updated[i];
+            int position = i < kForsythCacheSize ? static_cast<int>(i) : -1;
+            cachePosition[v] = position;
+            float score = scores.vertex(position, liveTriangles[v]);
+            float delta = score - vertexScore[v];
+            vertexScore[v] = score;
+            const uint32_t* live = &adjacency[adjacencyOffset[v]];
+            for (uint32_t j = 0; j < liveTriangles[v]; ++j) {
+                triangleScore[live[j]] += delta;
+            }
+        }
+        cacheCount = std::min<size_t>(updatedCount, kForsythCacheSize);
+        std::copy(updated, updated + cacheCount, cache);
+
+        // the next triangle is the best scoring one touching the cache
+        best = -1;
+        float bestScore = 0.0f;
+        for (size_t i = 0; i < cacheCount; ++i) {
+            uint32_t v = cache[i];
+            const uint32_t* live = &adjacency[adjacencyOffset[v]];
+            for (uint32_t j = 0; j < liveTriangles[v]; ++j) {
+                if (triangleScore[live[j]] > bestScore) {
+                    bestScore = triangleScore[live[j]];
+                    best = live[j];
+                }
+            }
+        }
+    }
+
+    std::copy(result.begin(), result.end(), indices.begin());
+}
+
+void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold) {
+    constexpr unsigned int kCacheSize = 16;
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2 || vertices.empty()) {
+        return;
+    }
+
+    // hard boundaries, triangles that miss on all three vertices start from a cold cache anyway
+    std::vector<uint32_t> triangleMisses(triangleCount);
+    std::vector<size_t> hardBoundaries;
+    {
+        FifoCache cache(vertices.size(), kCacheSize);
+        for (size_t t = 0; t < triangleCount; ++t) {
+            uint32_t misses = 0;
+            for (int k = 0; k < 3; ++k) {
+                misses += cache.access(indices[t * 3 + k]) ? 1 : 0;
+            }
+            triangleMisses[t] = misses;
+            if (t == 0 || misses == 3) {
+                hardBoundaries.push_back(t);
+            }
+        }
+        hardBoundaries.push_back(triangleCount);
+    }
+
+    // soft boundaries, cut inside a hard cluster wherever the run so far already has an ACMR
+    // within threshold of the whole cluster, restarting the cache there costs about that much
+    std::vector<size_t> clusters;
+    {
+        FifoCache cache(vertices.size(), kCacheSize);
+        for (size_t h = 0; h + 1 < hardBoundaries.size(); ++h) {
+            size_t start = hardBoundaries[h];
+            size_t end = hardBoundaries[h + 1];
+            uint32_t clusterMisses = 0;
+            for (size_t t = start; t < end; ++t) {
+                clusterMisses += triangleMisses[t];
+            }
+            float clusterThreshold = threshold * float(clusterMisses) / float(end - start);
+
+            clusters.push_back(start);
+            cache.flush();
+            uint32_t runMisses = 0;
+            size_t runStart = start;
+            for (size_t t = start; t < end; ++t) {
+                for (int k = 0; k < 3; ++k) {
+                    runMisses += cache.access(indices[t * 3 + k]) ? 1 : 0;
+                }
+                if (t + 1 < end && float(runMisses) / float(t + 1 - runStart) <= clusterThreshold) {
+                    clusters.push_back(t + 1);
+                    cache.flush();
+                    runMisses = 0;
+                    runStart = t + 1;
+                }
+            }
+        }
+        clusters.push_back(triangleCount);
+    }
+
+    // sort key, how far the cluster sits out from the mesh centroid along its own normal
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    std::vector<glm::vec3> clusterCentroid(clusters.size() - 1, glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormal(clusters.size() - 1, glm::vec3(0.0f));
+    std::vector<float> clusterArea(clusters.size() - 1, 0.0f);
+    for (size_t c = 0; c + 1 < clusters.size(); ++c) {
+        for (size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+            const glm::vec3& a = vertices[indices[t * 3 + 0]].position;
+            const glm::vec3& b = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3& d = vertices[indices[t * 3 + 2]].position;
+            glm::vec3 normal = glm::cross(b - a, d - a);
+            float area = glm::length(normal);
+            glm::vec3 centroid = (a + b + d) / 3.0f;
+            clusterCentroid[c] += centroid * area;
+            clusterNormal[c] += normal;
+            clusterArea[c] += area;
+        }
+        meshCentroid += clusterCentroid[c];
+        meshArea += clusterArea[c];
+    }
+    if (meshArea > 0.0f) {
+        meshCentroid /= meshArea;
+    }
+
+    std::vector<float> clusterKey(clusters.size() - 1, 0.0f);
+    std::vector<uint32_t> order(clusters.size() - 1);
+    for (size_t c = 0; c < order.size(); ++c) {
+        order[c] = static_cast<uint32_t>(c);
+        float normalLength = glm::length(clusterNormal[c]);
+        if (clusterArea[c] > 0.0f && normalLength > 0.0f) {
+            clusterKey[c] = glm::dot(clusterCentroid[c] / clusterArea[c] - meshCentroid, clusterNormal[c] / normalLength);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&clusterKey](uint32_t a, uint32_t b) { return clusterKey[a] > clusterKey[b]; });
+
+    std::vector<uint32_t> result;
+    result.reserve(triangleCount * 3);
+    for (uint32_t c : order) {
+        result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+    }
+    std::copy(result.begin(), result.end(), indices.begin());
+}
+
+void optimizeVertexFetch(Mesh& mesh) {
+    std::vector<uint32_t> remap(mesh.vertices.size(), UINT32_MAX);
+    std::vector<Vertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+    for (uint32_t& index : mesh.indices) {
+        if (remap[index] == UINT32_MAX) {
+            remap[index] = static_cast<uint32_t>(vertices.size());
+            vertices.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+    mesh.vertices = std::move(vertices);
+}
+
+void optimizeMesh(Mesh& mesh) {
+    if (mesh.submeshes.size() <= 1) {
+        optimizeVertexCache(mesh.indices, mesh.vertices.size());
+        optimizeOverdraw(mesh.indices, mesh.vertices);
+    } else {
+        // triangles must stay inside their material range, each range is reordered on its own
+        std::vector<uint32_t> range;
+        for (const Submesh& submesh : mesh.submeshes) {
+            auto begin = mesh.indices.begin() + submesh.indexOffset;
+            range.assign(begin, begin + submesh.indexCount);
+            optimizeVertexCache(range, mesh.vertices.size());
+            optimizeOverdraw(range, mesh.vertices);
+            std::copy(range.begin(), range.end(), begin);
+        }
+    }
+    optimizeVertexFetch(mesh);
+}
@@ -0,0 +1,41 @@
+#ifndef MESHOPTIMIZER_HPP
+#define MESHOPTIMIZER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Model.hpp"
+
+// triangle and vertex reordering run on welded meshes before they are cached
+// none of these change what is drawn, only the order it is drawn and fetched in
+//
+// ACMR: post transform cache misses per triangle (0.5 is the ideal, 3 the worst)
+// ATVR: post transform cache misses per vertex (1.0 is the ideal)
+
+struct VertexCacheStats {
+    float acmr = 0.0f;
+    float atvr = 0.0f;
+};
+
+// simulates a FIFO post transform cache of cacheSize entries over indices
+VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, unsigned int cacheSize = 16);
+
+// reorders triangles for vertex cache reuse, Tom Forsyth's linear speed algorithm
+// scored against a 32 entry LRU cache, which also suits small FIFO caches
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+// reorders clusters of cache ordered triangles so outward facing ones draw first
+// (better early z rejection), clusters are cut where the cache restarts and where the
+// local ACMR is within threshold of the cluster's, so threshold trades ACMR for overdraw
+void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold = 1.05f);
+
+// reorders vertices into first use order so fetches walk memory forward,
+// vertices no index refers to are dropped
+void optimizeVertexFetch(Mesh& mesh);
+
+// all three passes in order, vertex cache, overdraw, vertex fetch, the first two
+// within each of mesh.submeshes so material ranges keep their triangles
+void optimizeMesh(Mesh& mesh);
+
+#endif // MESHOPTIMIZER_HPP
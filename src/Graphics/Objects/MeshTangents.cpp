@@ -0,0 +1,302 @@
+#include "MeshTangents.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "VertexWeld.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TANGENTS_SSE2 1
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+#define TANGENTS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+    constexpr size_t kLanes = 4;
+    constexpr float kPi = 3.14159265f;
+    // lengths below this count as zero (degenerate triangles, repeated uvs)
+    constexpr float kTinyLength = 1e-12f;
+
+    // four floats, one triangle per lane, with the few operations the kernels need
+#if TANGENTS_SSE2
+    struct Lanes {
+        __m128 v;
+    };
+    Lanes load(const float* p) { return {_mm_load_ps(p)}; }
+    void store(float* p, Lanes a) { _mm_store_ps(p, a.v); }
+    Lanes splat(float value) { return {_mm_set1_ps(value)}; }
+    Lanes operator+(Lanes a, Lanes b) { return {_mm_add_ps(a.v, b.v)}; }
+    Lanes operator-(Lanes a, Lanes b) { return {_mm_sub_ps(a.v, b.v)}; }
+    Lanes operator*(Lanes a, Lanes b) { return {_mm_mul_ps(a.v, b.v)}; }
+    Lanes operator/(Lanes a, Lanes b) { return {_mm_div_ps(a.v, b.v)}; }
+    Lanes minimum(Lanes a, Lanes b) { return {_mm_min_ps(a.v, b.v)}; }
+    Lanes maximum(Lanes a, Lanes b) { return {_mm_max_ps(a.v, b.v)}; }
+    Lanes squareRoot(Lanes a) { return {_mm_sqrt_ps(a.v)}; }
+    Lanes absolute(Lanes a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+    // all bits set in the lanes where a < b, for select
+    Lanes less(Lanes a, Lanes b) { return {_mm_cmplt_ps(a.v, b.v)}; }
+    Lanes select(Lanes mask, Lanes a, Lanes b) { return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))}; }
+#elif TANGENTS_NEON
+    struct Lanes {
+        float32x4_t v;
+    };
+    Lanes load(const float* p) { return {vld1q_f32(p)}; }
+    void store(float* p, Lanes a) { vst1q_f32(p, a.v); }
+    Lanes splat(float value) { return {vdupq_n_f32(value)}; }
+    Lanes operator+(Lanes a, Lanes b) { return {vaddq_f32(a.v, b.v)}; }
+    Lanes operator-(Lanes a, Lanes b) { return {vsubq_f32(a.v, b.v)}; }
+    Lanes operator*(Lanes a, Lanes b) { return {vmulq_f32(a.v, b.v)}; }
+    Lanes operator/(Lanes a, Lanes b) { return {vdivq_f32(a.v, b.v)}; }
+    Lanes minimum(Lanes a, Lanes b) { return {vminq_f32(a.v, b.v)}; }
+    Lanes maximum(Lanes a, Lanes b) { return {vmaxq_f32(a.v, b.v)}; }
+    Lanes squareRoot(Lanes a) { return {vsqrtq_f32(a.v)}; }
+    Lanes absolute(Lanes a) { return {vabsq_f32(a.v)}; }
+    Lanes less(Lanes a, Lanes b) { return {vreinterpretq_f32_u32(vcltq_f32(a.v, b.v))}; }
+    Lanes select(Lanes mask, Lanes a, Lanes b) { return {vbslq_f32(vreinterpretq_u32_f32(mask.v), a.v, b.v)}; }
+#else
+    struct Lanes {
+        float v[kLanes];
+    };
+    template <typename Op>
+    Lanes apply(Lanes a, Lanes b, Op op) {
+        Lanes result;
+        for (size_t i = 0; i < kLanes; ++i) {
+            result.v[i] = op(a.v[i], b.v[i]);
+        }
+        return result;
+    }
+    Lanes load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+    void store(float* p, Lanes a) { std::copy(a.v, a.v + kLanes, p); }
+    Lanes splat(float value) { return {{value, value, value, value}}; }
+    Lanes operator+(Lanes a, Lanes b) { return apply(a, b, [](float x, float y) { return x + y; }); }
+    Lanes operator-(Lanes a, Lanes b) { return apply(a, b, [](float x, float y) { return x - y; }); }
+    Lanes operator*(Lanes a, Lanes b) { return apply(a, b, [](float x, float y) { return x * y; }); }
+    Lanes operator/(Lanes a, Lanes b) { return apply(a, b, [](float x, float y) { return x / y; }); }
+    Lanes minimum(Lanes a, Lanes b) { return apply(a, b, [](float x, float y) { return std::min(x, y); }); }
+    Lanes maximum(Lanes a, Lanes b) { return apply(a, b, [](float x, float y) { return std::max(x, y); }); }
+    Lanes squareRoot(Lanes a) { return apply(a, a, [](float x, float) { return std::sqrt(x); }); }
+    Lanes absolute(Lanes a) { return apply(a, a, [](float x, float) { return std::fabs(x); }); }
+    // 1 where a < b, select only tests for non zero
+    Lanes less(Lanes a, Lanes b) { return apply(a, b, [](float x, float y) { return x < y ? 1.0f : 0.0f; }); }
+    Lanes select(Lanes mask, Lanes a, Lanes b) {
+        Lanes result;
+        for (size_t i = 0; i < kLanes; ++i) {
+            result.v[i] = mask.v[i] != 0.0f ? a.v[i] : b.v[i];
+        }
+        return result;
+    }
+#endif
+
+    struct Lanes3 {
+        Lanes x, y, z;
+    };
+    Lanes3 load3(const float (*rows)[kLanes]) { return {load(rows[0]), load(rows[1]), load(rows[2])}; }
+    void store3(float (*rows)[kLanes], const Lanes3& a) {
+        store(rows[0], a.x);
+        store(rows[1], a.y);
+        store(rows[2], a.z);
+    }
+    Lanes3 operator-(const Lanes3& a, const Lanes3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+    Lanes3 operator*(const Lanes3& a, Lanes s) { return {a.x * s, a.y * s, a.z * s}; }
+    Lanes dot(const Lanes3& a, const Lanes3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    Lanes3 cross(const Lanes3& a, const Lanes3& b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+    // zero vectors stay zero
+    Lanes3 normalize(const Lanes3& a) { return a * (splat(1.0f) / maximum(squareRoot(dot(a, a)), splat(kTinyLength))); }
+
+    // within 7e-5 radians (Abramowitz and Stegun 4.4.45), plenty for a weight
+    Lanes arcCos(Lanes x) {
+        Lanes a = minimum(absolute(x), splat(1.0f));
+        Lanes poly = ((splat(-0.0187293f) * a + splat(0.0742610f)) * a + splat(-0.2121144f)) * a + splat(1.5707288f);
+        Lanes angle = squareRoot(splat(1.0f) - a) * poly;
+        return select(less(x, splat(0.0f)), splat(kPi) - angle, angle);
+    }
+
+    Lanes angleBetween(const Lanes3& a, const Lanes3& b) {
+        Lanes lengths = squareRoot(dot(a, a) * dot(b, b));
+        return arcCos(dot(a, b) / maximum(lengths, splat(kTinyLength)));
+    }
+
+    // four triangles as [corner][component][lane], lanes past count are zero, a degenerate
+    // triangle whose weights come out zero
+    struct TriangleBatch {
+        alignas(16) float position[3][3][kLanes];
+        alignas(16) float texCoord[3][2][kLanes];
+        alignas(16) float normal[3][3][kLanes];
+        uint32_t index[3][kLanes];
+        size_t count;
+    };
+
+    size_t fullIndexCount(const Mesh& mesh) {
+        return mesh.lods.empty() ? mesh.indices.size() : mesh.lods[0].indexCount;
+    }
+
+    void gatherBatch(const Mesh& mesh, size_t first, size_t triangleCount, bool withFrames, TriangleBatch& batch) {
+        batch.count = std::min(kLanes, triangleCount - first);
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            for (int k = 0; k < 3; ++k) {
+                Vertex vertex{};
+                batch.index[k][lane] = 0;
+                if (lane < batch.count) {
+                    batch.index[k][lane] = mesh.indices[(first + lane) * 3 + k];
+                    vertex = mesh.vertices[batch.index[k][lane]];
+                }
+                for (int axis = 0; axis < 3; ++axis) {
+                    batch.position[k][axis][lane] = vertex.position[axis];
+                }
+                if (withFrames) {
+                    for (int axis = 0; axis < 3; ++axis) {
+                        batch.normal[k][axis][lane] = vertex.normal[axis];
+                    }
+                    batch.texCoord[k][0][lane] = vertex.texCoord.x;
+                    batch.texCoord[k][1][lane] = vertex.texCoord.y;
+                }
+            }
+        }
+    }
+
+    // unit face normals and the angle at each corner
+    void cornerAngles(const TriangleBatch& batch, float (*faceNormal)[kLanes], float (*angle)[kLanes]) {
+        Lanes3 p0 = load3(batch.position[0]);
+        Lanes3 p1 = load3(batch.position[1]);
+        Lanes3 p2 = load3(batch.position[2]);
+        Lanes3 e01 = p1 - p0, e02 = p2 - p0, e12 = p2 - p1;
+        store3(faceNormal, normalize(cross(e01, e02)));
+        store(angle[0], angleBetween(e01, e02));
+        store(angle[1], angleBetween(p0 - p1, e12));
+        store(angle[2], angleBetween(p0 - p2, p1 - p2));
+    }
+
+    // dP/du and dP/dv of each triangle projected into each corner's normal plane, unit
+    // length times the corner angle
+    void cornerTangents(const TriangleBatch& batch, const float (*angle)[kLanes], float (*tangent)[3][kLanes], float (*bitangent)[3][kLanes]) {
+        Lanes3 p0 = load3(batch.position[0]);
+        Lanes3 e1 = load3(batch.position[1]) - p0;
+        Lanes3 e2 = load3(batch.position[2]) - p0;
+        Lanes u0 = load(batch.texCoord[0][0]), v0 = load(batch.texCoord[0][1]);
+        Lanes du1 = load(batch.texCoord[1][0]) - u0, dv1 = load(batch.texCoord[1][1]) - v0;
+        Lanes du2 = load(batch.texCoord[2][0]) - u0, dv2 = load(batch.texCoord[2][1]) - v0;
+
+        // only the sign of the uv area is applied, the directions are all that is kept and
+        // dividing by a near zero area would only lose precision; zero area gives zero
+        Lanes area = du1 * dv2 - du2 * dv1;
+        Lanes zero = splat(0.0f);
+        Lanes sign = select(less(area, zero), splat(-1.0f), select(less(zero, area), splat(1.0f), zero));
+        Lanes3 faceTangent = (Lanes3{e1.x * dv2, e1.y * dv2, e1.z * dv2} - Lanes3{e2.x * dv1, e2.y * dv1, e2.z * dv1}) * sign;
+        Lanes3 faceBitangent = (Lanes3{e2.x * du1, e2.y * du1, e2.z * du1} - Lanes3{e1.x * du2, e1.y * du2, e1.z * du2}) * sign;
+
+        for (int k = 0; k < 3; ++k) {
+            Lanes3 normal = load3(batch.normal[k]);
+            Lanes weight = load(angle[k]);
+            store3(tangent[k], normalize(faceTangent - normal * dot(normal, faceTangent)) * weight);
+            store3(bitangent[k], normalize(faceBitangent - normal * dot(normal, faceBitangent)) * weight);
+        }
+    }
+}
+
+bool generateNormals(Mesh& mesh) {
+    bool missing = false;
+    for (const Vertex& vertex : mesh.vertices) {
+        if (vertex.normal == glm::vec3(0.0f)) {
+            missing = true;
+            break;
+        }
+    }
+    if (!missing) {
+        return false;
+    }
+
+    // vertices split by uvs or colors still share one smooth normal
+    std::vector<glm::vec3> groupPosition;
+    std::vector<uint32_t> group(mesh.vertices.size());
+    {
+        VertexWeldTable<glm::vec3> positions(groupPosition, mesh.vertices.size() / 2);
+        for (size_t v = 0; v < mesh.vertices.size(); ++v) {
+            // the weld compares bytes, fold -0.0 so mirrored positions land in one group
+            const glm::vec3& position = mesh.vertices[v].position;
+            group[v] = positions.weld(glm::vec3(weldZero(position.x), weldZero(position.y), weldZero(position.z)));
+        }
+    }
+    std::vector<glm::vec3> sums(groupPosition.size(), glm::vec3(0.0f));
+
+    size_t triangleCount = fullIndexCount(mesh) / 3;
+    TriangleBatch batch;
+    alignas(16) float faceNormal[3][kLanes];
+    alignas(16) float angle[3][kLanes];
+    for (size_t first = 0; first < triangleCount; first += kLanes) {
+        gatherBatch(mesh, first, triangleCount, false, batch);
+        cornerAngles(batch, faceNormal, angle);
+        for (size_t lane = 0; lane < batch.count; ++lane) {
+            glm::vec3 normal(faceNormal[0][lane], faceNormal[1][lane], faceNormal[2][lane]);
+            for (int k = 0; k < 3; ++k) {
+                sums[group[batch.index[k][lane]]] += normal * angle[k][lane];
+            }
+        }
+    }
+
+    for (size_t v = 0; v < mesh.vertices.size(); ++v) {
+        Vertex& vertex = mesh.vertices[v];
+        float length = glm::length(sums[group[v]]);
+        if (vertex.normal == glm::vec3(0.0f) && length > kTinyLength) {
+            vertex.normal = sums[group[v]] / length;
+        }
+    }
+    return true;
+}
+
+bool generateTangents(Mesh& mesh) {
+    mesh.tangents.clear();
+    bool hasTexCoords = false;
+    for (const Vertex& vertex : mesh.vertices) {
+        if (vertex.texCoord != glm::vec2(0.0f)) {
+            hasTexCoords = true;
+            break;
+        }
+    }
+    if (!hasTexCoords) {
+        return false;
+    }
+
+    std::vector<glm::vec3> tangentSums(mesh.vertices.size(), glm::vec3(0.0f));
+    std::vector<glm::vec3> bitangentSums(mesh.vertices.size(), glm::vec3(0.0f));
+    size_t triangleCount = fullIndexCount(mesh) / 3;
+    TriangleBatch batch;
+    alignas(16) float faceNormal[3][kLanes];
+    alignas(16) float angle[3][kLanes];
+    alignas(16) float tangent[3][3][kLanes];
+    alignas(16) float bitangent[3][3][kLanes];
+    for (size_t first = 0; first < triangleCount; first += kLanes) {
+        gatherBatch(mesh, first, triangleCount, true, batch);
+        cornerAngles(batch, faceNormal, angle);
+        cornerTangents(batch, angle, tangent, bitangent);
+        for (size_t lane = 0; lane < batch.count; ++lane) {
+            for (int k = 0; k < 3; ++k) {
+                uint32_t vertex = batch.index[k][lane];
+                tangentSums[vertex] += glm::vec3(tangent[k][0][lane], tangent[k][1][lane], tangent[k][2][lane]);
+                bitangentSums[vertex] += glm::vec3(bitangent[k][0][lane], bitangent[k][1][lane], bitangent[k][2][lane]);
+            }
+        }
+    }
+
+    mesh.tangents.resize(mesh.vertices.size());
+    for (size_t v = 0; v < mesh.vertices.size(); ++v) {
+        const glm::vec3& normal = mesh.vertices[v].normal;
+        glm::vec3 direction = tangentSums[v] - normal * glm::dot(normal, tangentSums[v]);
+        float length = glm::length(direction);
+        if (length > kTinyLength) {
+            direction /= length;
+        } else {
+            // no uv gradient reached this vertex, any direction in the normal plane keeps
+            // shaders finite
+            glm::vec3 axis = std::fabs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+            direction = glm::cross(normal, axis);
+            float axisLength = glm::length(direction);
+            direction = axisLength > kTinyLength ? direction / axisLength : axis;
+        }
+        float handedness = glm::dot(glm::cross(normal, direction), bitangentSums[v]) < 0.0f ? -1.0f : 1.0f;
+        mesh.tangents[v] = glm::vec4(direction, handedness);
+    }
+    return true;
+}
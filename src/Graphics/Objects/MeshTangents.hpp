@@ -0,0 +1,24 @@
+#ifndef MESHTANGENTS_HPP
+#define MESHTANGENTS_HPP
+
+#include "Model.hpp"
+
+// smooth normals and tangent frames for meshes whose OBJ left them out
+//
+// both weight every triangle corner by its angle, so a vertex's frame does not depend
+// on how the surface around it happens to be triangulated; the per triangle math runs
+// four triangles at a time with SSE2 or NEON, the sums per vertex are plain loops
+// tangents follow the MikkTSpace conventions: the tangent points along increasing u,
+// is orthogonal to the vertex normal, and the bitangent is w * cross(normal, tangent)
+// unlike MikkTSpace a vertex is never split, corners whose uv winding disagrees
+// (mirrored uvs meeting without a seam) vote for w
+
+// fills the normals of vertices the OBJ gave none (zero length), vertices sharing a position
+// get the same normal so uv seams stay smooth, false when every vertex already had one
+bool generateNormals(Mesh& mesh);
+
+// fills mesh.tangents from the normals and uvs of lods[0], cleared when the mesh has no uvs
+// run it after anything that reorders vertices
+bool generateTangents(Mesh& mesh);
+
+#endif // MESHTANGENTS_HPP
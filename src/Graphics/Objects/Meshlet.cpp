@@ -0,0 +1,289 @@
+#include "Meshlet.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Model.hpp"
+
+namespace
+{
+    constexpr uint8_t kNotInMeshlet = 0xff;
+    // normals closer than this to perpendicular to the cone axis make the cone useless
+    constexpr float kMinConeDot = 0.1f;
+
+    // Ritter's sphere, starts from the farthest pair along the widest axis and grows
+    // until every point is inside, within a few percent of the minimal sphere
+    void boundingSphere(const std::vector<glm::vec3>& points, glm::vec3& center, float& radius) {
+        size_t minimum[3] = {0, 0, 0}, maximum[3] = {0, 0, 0};
+        for (size_t i = 1; i < points.size(); ++i) {
+            for (int axis = 0; axis < 3; ++axis) {
+                if (points[i][axis] < points[minimum[axis]][axis]) {
+                    minimum[axis] = i;
+                }
+                if (points[i][axis] > points[maximum[axis]][axis]) {
+                    maximum[axis] = i;
+                }
+            }
+        }
+        int widest = 0;
+        float widestDistance = -1.0f;
+        for (int axis = 0; axis < 3; ++axis) {
+            glm::vec3 span = points[maximum[axis]] - points[minimum[axis]];
+            float distance = glm::dot(span, span);
+            if (distance > widestDistance) {
+                widestDistance = distance;
+                widest = axis;
+            }
+        }
+
+        center = (points[minimum[widest]] + points[maximum[widest]]) * 0.5f;
+        radius = std::sqrt(widestDistance) * 0.5f;
+        for (const glm::vec3& point : points) {
+            glm::vec3 offset = point - center;
+            float distance = glm::length(offset);
+            if (distance > radius) {
+                // move the center toward the point just enough to cover it
+                float grown = (radius + distance) * 0.5f;
+                center += offset * ((grown - radius) / distance);
+                radius = grown;
+            }
+        }
+    }
+
+    void computeBounds(const Mesh& mesh, Meshlet& meshlet) {
+        std::vector<glm::vec3> points(meshlet.vertexCount);
+        for (uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+            points[i] = mesh.vertices[mesh.meshletVertices[meshlet.vertexOffset + i]].position;
+        }
+        boundingSphere(points, meshlet.center, meshlet.radius);
+
+        // cone axis is the mean face normal, its cutoff comes from the widest normal
+        std::vector<glm::vec3> normals;
+        normals.reserve(meshlet.triangleCount);
+        glm::vec3 normalSum(0.0f);
+        const uint8_t* triangles = mesh.meshletTriangles.data() + meshlet.triangleOffset;
+        for (uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+            const glm::vec3& a = points[triangles[t * 3 + 0]];
+            const glm::vec3& b = points[triangles[t * 3 + 1]];
+            const glm::vec3& c = points[triangles[t * 3 + 2]];
+            glm::vec3 normal = glm::cross(b - a, c - a);
+            float area = glm::length(normal);
+            // degenerate triangles can face any way and are never drawn, leave them out
+            if (area <= 0.0f) {
+                normals.push_back(glm::vec3(0.0f));
+                continue;
+            }
+            normal /= area;
+            normals.push_back(normal);
+            normalSum += normal;
+        }
+
+        meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+        meshlet.coneCutoff = 1.0f;
+        meshlet.coneApex = meshlet.center;
+        float axisLength = glm::length(normalSum);
+        if (axisLength <= 0.0f) {
+            return;
+        }
+        glm::vec3 axis = normalSum / axisLength;
+        float minDot = 1.0f;
+        for (const glm::vec3& normal : normals) {
+            if (normal != glm::vec3(0.0f)) {
+                minDot = std::min(minDot, glm::dot(normal, axis));
+            }
+        }
+        meshlet.coneAxis = axis;
+        if (minDot <= kMinConeDot) {
+            return;
+        }
+
+        // the apex goes back along the axis until it is behind every triangle's plane,
+        // so any camera inside the cone sees all of them from behind
+        float apexDistance = 0.0f;
+        for (uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+            if (normals[t] == glm::vec3(0.0f)) {
+                continue;
+            }
+            float planeDistance = glm::dot(meshlet.center - points[triangles[t * 3]], normals[t]);
+            apexDistance = std::max(apexDistance, planeDistance / glm::dot(axis, normals[t]));
+        }
+        meshlet.coneApex = meshlet.center - axis * apexDistance;
+        meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+}
+
+void generateMeshlets(Mesh& mesh) {
+    mesh.meshlets.clear();
+    mesh.meshletVertices.clear();
+    mesh.meshletTriangles.clear();
+
+    size_t indexCount = mesh.lods.empty() ? mesh.indices.size() : mesh.lods[0].indexCount;
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+    const uint32_t* indices = mesh.indices.data();
+    size_t vertexCount = mesh.vertices.size();
+
+    // triangles around each vertex, items of v are triangles[offsets[v] .. offsets[v + 1])
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        ++offsets[indices[i] + 1];
+    }
+    for (size_t v = 0; v < vertexCount; ++v) {
+        offsets[v + 1] += offsets[v];
+    }
+    std::vector<uint32_t> vertexTriangles(triangleCount * 3);
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; ++i) {
+            vertexTriangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    // a meshlet never spans two materials, each range of lods[0] is split on its own
+    std::vector<Submesh> ranges;
+    if (!mesh.lods.empty()) {
+        ranges.assign(mesh.submeshes.begin() + mesh.lods[0].submeshOffset, mesh.submeshes.begin() + mesh.lods[0].submeshOffset + mesh.lods[0].submeshCount);
+    }
+    if (ranges.empty()) {
+        ranges.push_back(Submesh{0, static_cast<uint32_t>(triangleCount * 3), 0});
+    }
+
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint8_t> localIndex(vertexCount, kNotInMeshlet);
+    std::vector<uint32_t> candidates;
+    size_t nextSeed = 0;
+    size_t rangeBegin = 0, rangeEnd = 0;
+    uint32_t material = 0;
+
+    Meshlet meshlet{};
+    glm::vec3 centroidSum(0.0f);
+
+    auto triangleCentroid = [&](uint32_t triangle) {
+        return (mesh.vertices[indices[triangle * 3]].position + mesh.vertices[indices[triangle * 3 + 1]].position +
+                mesh.vertices[indices[triangle * 3 + 2]].position) * (1.0f / 3.0f);
+    };
+    auto newVertices = [&](uint32_t triangle) {
+        uint32_t count = 0;
+        for (int k = 0; k < 3; ++k) {
+            count += localIndex[indices[triangle * 3 + k]] == kNotInMeshlet ? 1 : 0;
+        }
+        return count;
+    };
+    auto flush = [&]() {
+        for (uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+            localIndex[mesh.meshletVertices[meshlet.vertexOffset + i]] = kNotInMeshlet;
+        }
+        computeBounds(mesh, meshlet);
+        mesh.meshlets.push_back(meshlet);
+        // keep every meshlet's triangles 4 byte aligned for 32 bit loads on the GPU
+        mesh.meshletTriangles.resize((mesh.meshletTriangles.size() + 3) & ~size_t(3), 0);
+
+        meshlet = Meshlet{};
+        meshlet.material = material;
+        meshlet.vertexOffset = static_cast<uint32_t>(mesh.meshletVertices.size());
+        meshlet.triangleOffset = static_cast<uint32_t>(mesh.meshletTriangles.size());
+        centroidSum = glm::vec3(0.0f);
+        candidates.clear();
+    };
+
+    for (const Submesh& range : ranges) {
+        rangeBegin = range.indexOffset / 3;
+        rangeEnd = rangeBegin + range.indexCount / 3;
+        nextSeed = rangeBegin;
+        material = range.material;
+        meshlet.material = material;
+        for (;;) {
+            // best neighbour: fewest new vertices, then closest to the meshlet's center,
+            // emitted candidates are dropped on the way
+            uint32_t best = UINT32_MAX;
+            uint32_t bestNew = 4;
+            float bestDistance = 0.0f;
+            glm::vec3 center = meshlet.triangleCount != 0 ? centroidSum / static_cast<float>(meshlet.triangleCount) : glm::vec3(0.0f);
+            size_t kept = 0;
+            for (uint32_t triangle : candidates) {
+                if (emitted[triangle]) {
+                    continue;
+                }
+                candidates[kept++] = triangle;
+                uint32_t added = newVertices(triangle);
+                if (added > bestNew) {
+                    continue;
+                }
+                glm::vec3 offset = triangleCentroid(triangle) - center;
+                float distance = glm::dot(offset, offset);
+                if (added < bestNew || distance < bestDistance) {
+                    best = triangle;
+                    bestNew = added;
+                    bestDistance = distance;
+                }
+            }
+            candidates.resize(kept);
+
+            // nothing connected left, continue with the next triangle in index order, which
+            // the vertex cache optimizer already left spatially coherent
+            if (best == UINT32_MAX) {
+                while (nextSeed < rangeEnd && emitted[nextSeed]) {
+                    ++nextSeed;
+                }
+                if (nextSeed == rangeEnd) {
+                    break;
+                }
+                best = static_cast<uint32_t>(nextSeed);
+                bestNew = newVertices(best);
+            }
+
+            if (meshlet.vertexCount + bestNew > kMeshletMaxVertices || meshlet.triangleCount == kMeshletMaxTriangles) {
+                flush();
+                bestNew = 3;
+            }
+
+            for (int k = 0; k < 3; ++k) {
+                uint32_t vertex = indices[best * 3 + k];
+                if (localIndex[vertex] == kNotInMeshlet) {
+                    localIndex[vertex] = static_cast<uint8_t>(meshlet.vertexCount++);
+                    mesh.meshletVertices.push_back(vertex);
+                    for (uint32_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+                        uint32_t neighbour = vertexTriangles[i];
+                        if (!emitted[neighbour] && neighbour >= rangeBegin && neighbour < rangeEnd) {
+                            candidates.push_back(neighbour);
+                        }
+                    }
+                }
+                mesh.meshletTriangles.push_back(localIndex[vertex]);
+            }
+            emitted[best] = 1;
+            ++meshlet.triangleCount;
+            centroidSum += triangleCentroid(best);
+        }
+        if (meshlet.triangleCount != 0) {
+            flush();
+        }
+    }
+}
+
+bool meshletVisible(const Meshlet& meshlet, const Frustum& frustum, const glm::vec3& camera) {
+    if (!sphereInFrustum(frustum, meshlet.center, meshlet.radius)) {
+        return false;
+    }
+    // dot(normalize(view), axis) > cutoff without the divide, a camera at the apex keeps it
+    glm::vec3 view = meshlet.coneApex - camera;
+    return !(glm::dot(view, meshlet.coneAxis) > meshlet.coneCutoff * glm::length(view));
+}
+
+void cullMeshlets(const Mesh& mesh, const Frustum& frustum, const glm::vec3& camera, std::vector<uint32_t>& visible) {
+    for (size_t i = 0; i < mesh.meshlets.size(); ++i) {
+        if (meshletVisible(mesh.meshlets[i], frustum, camera)) {
+            visible.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+void appendMeshletIndices(const Mesh& mesh, const Meshlet& meshlet, std::vector<uint32_t>& indices) {
+    const uint32_t* vertices = mesh.meshletVertices.data() + meshlet.vertexOffset;
+    const uint8_t* triangles = mesh.meshletTriangles.data() + meshlet.triangleOffset;
+    for (uint32_t i = 0; i < meshlet.triangleCount * 3; ++i) {
+        indices.push_back(vertices[triangles[i]]);
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef MESHLET_HPP
+#define MESHLET_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "ObjectUtils.hpp"
+
+// meshlets split the full level of detail (lods[0]) of a Mesh into small clusters of
+// triangles that are culled as a unit, on the CPU today and by a mesh / compute shader later
+//
+// each meshlet lists up to kMeshletMaxVertices mesh vertices in Mesh::meshletVertices and
+// up to kMeshletMaxTriangles triangles as three one byte indices into that list in
+// Mesh::meshletTriangles, the sizes fit the common mesh shader limits
+// culling data is in object space, transform the frustum and camera into it
+
+struct Mesh;
+
+inline constexpr size_t kMeshletMaxVertices = 64;
+inline constexpr size_t kMeshletMaxTriangles = 124;
+
+struct Meshlet {
+    uint32_t vertexOffset;    // first entry in Mesh::meshletVertices
+    uint32_t triangleOffset;  // first byte in Mesh::meshletTriangles, 4 byte aligned
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+    // bounding sphere of the meshlet's vertices
+    glm::vec3 center;
+    float radius;
+    // every triangle faces away from cameras inside the cone with this apex around
+    // coneAxis, coneCutoff is the sine of its half angle, 1 when the normals spread too far
+    glm::vec3 coneAxis;
+    float coneCutoff;
+    glm::vec3 coneApex;
+    uint32_t material;  // Submesh::material of the range it was cut from
+};
+// 16 byte rows so the array can be uploaded as is to a std430 buffer
+static_assert(sizeof(Meshlet) == 64, "Meshlet must stay 64 bytes");
+
+// fills mesh.meshlets, mesh.meshletVertices and mesh.meshletTriangles from lods[0]
+// (or all indices when the mesh has no LODs), greedily growing each meshlet by the
+// neighbouring triangle that adds the fewest vertices and stays closest to its center
+// meshlets follow the material ranges of lods[0] and never mix two materials
+void generateMeshlets(Mesh& mesh);
+
+// false when the meshlet is outside the frustum or all its triangles face away from camera
+bool meshletVisible(const Meshlet& meshlet, const Frustum& frustum, const glm::vec3& camera);
+
+// appends the indices of the meshlets meshletVisible passes to visible
+void cullMeshlets(const Mesh& mesh, const Frustum& frustum, const glm::vec3& camera, std::vector<uint32_t>& visible);
+
+// appends the triangles of one meshlet as mesh vertex indices, for drawing culled
+// meshlets through the regular index buffer path
+void appendMeshletIndices(const Mesh& mesh, const Meshlet& meshlet, std::vector<uint32_t>& indices);
+
+#endif // MESHLET_HPP
@@ -1,85 +1,595 @@
 #include "Model.hpp"
 
-Model::Model(const std::string& filepath)
+#include <algorithm>
+#include <filesystem>
+
+#include "MeshCache.hpp"
+#include "MeshLod.hpp"
+#include "MeshOptimizer.hpp"
+#include "Meshlet.hpp"
+#include "MeshTangents.hpp"
+#include "ObjParser.hpp"
+#include "VertexWeld.hpp"
+#include "Utils/MappedFile.hpp"
+#include "Utils/ThreadPool.hpp"
+
+namespace
+{
+    // shapes with fewer corners than this are welded on one thread
+    constexpr size_t kParallelWeldCorners = 1 << 16;
+    // closed triangle meshes share a vertex between about six corners, uv seams and
+    // hard edges lower that, the weld table starts at this guess and grows past it
+    constexpr size_t kCornersPerVertex = 4;
+
+    Vertex makeVertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& index, bool hasColors) {
+        // signed zeros are folded so the byte weld keeps one vertex for 0.0 and -0.0
+        Vertex vertex{};
+
+        vertex.position = {
+            weldZero(attrib.vertices[3 * index.vertex_index + 0]),
+            weldZero(attrib.vertices[3 * index.vertex_index + 1]),
+            weldZero(attrib.vertices[3 * index.vertex_index + 2])
+        };
+
+        if (index.normal_index >= 0) {
+            vertex.normal = {
+                weldZero(attrib.normals[3 * index.normal_index + 0]),
+                weldZero(attrib.normals[3 * index.normal_index + 1]),
+                weldZero(attrib.normals[3 * index.normal_index + 2])
+            };
+        }
+
+        if (index.texcoord_index >= 0) {
+            vertex.texCoord = {
+                weldZero(attrib.texcoords[2 * index.texcoord_index + 0]),
+                weldZero(attrib.texcoords[2 * index.texcoord_index + 1])
+            };
+        }
+
+        // Load vertex colors if available (RGB format)
+        if (hasColors && index.vertex_index * 3 + 2 < attrib.colors.size()) {
+            vertex.color = {
+                weldZero(attrib.colors[3 * index.vertex_index + 0]),
+                weldZero(attrib.colors[3 * index.vertex_index + 1]),
+                weldZero(attrib.colors[3 * index.vertex_index + 2])
+            };
+        } else {
+            // Default to white if no color is specified
+            vertex.color = glm::vec3(1.0f, 1.0f, 1.0f);
+        }
+        return vertex;
+    }
+
+    // welds corners [begin, end) of a shape, vertices come out in first use order
+    void weldCorners(const tinyobj::attrib_t& attrib, const tinyobj::index_t* begin, const tinyobj::index_t* end,
+                     std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+        size_t cornerCount = static_cast<size_t>(end - begin);
+        // every corner is one index, which also bounds the unique vertex count
+        indices.reserve(indices.size() + cornerCount);
+        vertices.reserve(vertices.size() + cornerCount);
+
+        VertexWeldTable<Vertex> uniqueVertices(vertices, cornerCount / kCornersPerVertex);
+
+        const bool hasColors = !attrib.colors.empty();
+        for (const tinyobj::index_t* index = begin; index != end; ++index) {
+            // one probe, appends the vertex when it is new
+            indices.push_back(uniqueVertices.weld(makeVertex(attrib, *index, hasColors)));
+        }
+
+        // the reserve above is the worst case, give the unused tail back
+        vertices.shrink_to_fit();
+    }
+
+    glm::vec3 toVec3(const tinyobj::real_t* values) {
+        return glm::vec3(values[0], values[1], values[2]);
+    }
+
+    ModelMaterial toModelMaterial(const tinyobj::material_t& source) {
+        ModelMaterial material;
+        material.name = source.name;
+        material.ambient = toVec3(source.ambient);
+        material.diffuse = toVec3(source.diffuse);
+        material.specular = toVec3(source.specular);
+        material.emission = toVec3(source.emission);
+        material.shininess = source.shininess;
+        material.dissolve = source.dissolve;
+        material.ior = source.ior;
+        material.illum = source.illum;
+        material.diffuseTexture = source.diffuse_texname;
+        material.specularTexture = source.specular_texname;
+        // exporters write normal maps as map_Bump / bump far more often than norm
+        material.normalTexture = source.bump_texname.empty() ? source.normal_texname : source.bump_texname;
+        material.alphaTexture = source.alpha_texname;
+        return material;
+    }
+
+    // index of the entry drawing like material, appended when there is none
+    uint32_t addMaterial(std::vector<ModelMaterial>& materials, ModelMaterial material) {
+        for (size_t i = 0; i < materials.size(); ++i) {
+            if (materials[i].drawsLike(material)) {
+                return static_cast<uint32_t>(i);
+            }
+        }
+        materials.push_back(std::move(material));
+        return static_cast<uint32_t>(materials.size() - 1);
+    }
+}
+
+Model::Model(const std::string& filepath, const ModelOptions& options) : options(options)
 {
-    loadOBJ(filepath);
+    loaded = loadOBJ(filepath);
+    if (loaded) {
+        computeBounds();
+        if (options.splitStreams) {
+            splitMeshStreams();
+        }
+        if (options.packVertices) {
+            packMeshes();
+        }
+    }
 }
 
 bool Model::loadOBJ(const std::string& filepath){
+    // one mapping serves the cache key and the native parser
+    MappedFile source;
+    bool mapped = (options.useMeshCache || options.nativeObjParser) && source.openRead(filepath);
+
+    // both parsers look for mtllib files next to the OBJ, not in the working directory
+    std::string materialDirectory = std::filesystem::path(filepath).parent_path().string();
+
+    // the cache is keyed on the OBJ and MTL bytes, hashing the mapped files is far cheaper than parsing them
+    std::string cachePath;
+    uint64_t sourceSize = 0;
+    uint64_t sourceHash = 0;
+    if (options.useMeshCache && mapped) {
+        sourceSize = source.size();
+        sourceHash = MeshCache::hashSource(source.data(), source.size(), materialDirectory);
+        cachePath = MeshCache::cachePathFor(filepath, options.cacheDirectory);
+        auto cacheStart = std::chrono::steady_clock::now();
+        if (MeshCache::read(cachePath, sourceSize, sourceHash, cacheSettings(), meshes, materials)) {
+            double cacheMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cacheStart).count();
+            logMessage(3, "Successfully loaded model: " + filepath + " (mesh cache)", {"Graphics", "Model"});
+            logMessage(4, logFormat("     Meshes: ", meshes.size(), ", materials: ", materials.size(), " from ", cachePath, " in ", std::fixed,
+                                    std::setprecision(2), cacheMs, " ms"),
+                       {"Graphics", "Model"});
+            return true;
+        }
+    }
+
     std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
+    std::vector<tinyobj::material_t> sourceMaterials;
     std::string warn, err;
-    bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str());
+    // files that cannot be mapped (empty ones) still go through tinyobj
+    bool nativeParse = options.nativeObjParser && mapped;
+    const char* parserName = nativeParse ? "ObjParser" : "TinyObjLoader";
+    auto parseStart = std::chrono::steady_clock::now();
+    bool ret;
+    if (nativeParse) {
+        ret = parseObj(reinterpret_cast<const char*>(source.data()), source.size(), materialDirectory, attrib, shapes, sourceMaterials, warn, err);
+    } else {
+        // tinyobj concatenates the base directory and the file name, so it needs the separator
+        std::string materialBaseDir = materialDirectory.empty() ? materialDirectory : materialDirectory + "/";
+        ret = tinyobj::LoadObj(&attrib, &shapes, &sourceMaterials, &warn, &err, filepath.c_str(), materialBaseDir.c_str());
+    }
+    double parseMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - parseStart).count();
+    size_t parsedBytes = source.size();
+    source.close();
     if (!warn.empty()) {
-        logMessage(2, "TinyObjLoader warning: " + warn, {"Graphics", "Model"});
+        logMessage(2, std::string(parserName) + " warning: " + warn, {"Graphics", "Model"});
     }
     if (!err.empty()) {
-        logMessage(1, "TinyObjLoader error: " + err, {"Graphics", "Model"});
+        logMessage(1, std::string(parserName) + " error: " + err, {"Graphics", "Model"});
     }
     if (!ret) {
         logMessage(1, "Failed to load/parse .obj file: " + filepath, {"Graphics", "Model"});
         return false;
     }
     
-    for (const auto& shape : shapes) {
-        Mesh mesh;
-        std::unordered_map<Vertex, uint32_t> uniqueVertices{};
-        for (const auto& index : shape.mesh.indices) {
-            Vertex vertex{};
-
-            vertex.position = {
-                attrib.vertices[3 * index.vertex_index + 0],
-                attrib.vertices[3 * index.vertex_index + 1],
-                attrib.vertices[3 * index.vertex_index + 2]
-            };
-
-            if (index.normal_index >= 0) {
-                vertex.normal = {
-                    attrib.normals[3 * index.normal_index + 0],
-                    attrib.normals[3 * index.normal_index + 1],
-                    attrib.normals[3 * index.normal_index + 2]
-                };
-            }
-
-            if (index.texcoord_index >= 0) {
-                vertex.texCoord = {
-                    attrib.texcoords[2 * index.texcoord_index + 0],
-                    attrib.texcoords[2 * index.texcoord_index + 1]
-                };
-            }
-
-            // Load vertex colors if available (RGB format)
-            if (!attrib.colors.empty() && index.vertex_index * 3 + 2 < attrib.colors.size()) {
-                vertex.color = {
-                    attrib.colors[3 * index.vertex_index + 0],
-                    attrib.colors[3 * index.vertex_index + 1],
-                    attrib.colors[3 * index.vertex_index + 2]
-                };
-            } else {
-                // Default to white if no color is specified
-                vertex.color = glm::vec3(1.0f, 1.0f, 1.0f);
-            }
+    // shapes are independent, each one is welded on its own pool thread and written
+    // straight into its slot so the mesh order matches the file
+    std::vector<uint32_t> materialRemap;
+    buildMaterials(sourceMaterials, shapes, materialRemap);
 
-            if (uniqueVertices.count(vertex) == 0) {
-                uniqueVertices[vertex] = static_cast<uint32_t>(mesh.vertices.size());
-                mesh.vertices.push_back(vertex);
-            }
-
-            mesh.indices.push_back(uniqueVertices[vertex]);
-        }
-        meshes.push_back(mesh);
+    auto weldStart = std::chrono::steady_clock::now();
+    meshes.resize(shapes.size());
+    ThreadPool::shared().parallelFor(shapes.size(), [&](size_t shapeIndex) {
+        buildMesh(shapes[shapeIndex], materialRemap, meshes[shapeIndex]);
+    });
+    if (options.mergeShapes) {
+        mergeMeshes();
     }
-    int total_faces = 0;
+    double weldMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - weldStart).count();
+
+    size_t total_faces = 0;
     for (const auto& shape : shapes) {
         total_faces += shape.mesh.num_face_vertices.size();
     }
+    size_t uniqueVertices = 0;
+    for (const auto& mesh : meshes) {
+        uniqueVertices += mesh.vertices.size();
+    }
     std::stringstream ss;
     ss << "     Total vertices: " << attrib.vertices.size() / 3 << "\n";
     ss << "     Total faces: " << total_faces << "\n";
     ss << "     Has vertex colors: " << (!attrib.colors.empty() ? "Yes" : "No") << "\n";
-    ss << "     Has texture coordinates: " << (!attrib.texcoords.empty() ? "Yes" : "No");
+    ss << "     Has texture coordinates: " << (!attrib.texcoords.empty() ? "Yes" : "No") << "\n";
+    if (parsedBytes > 0 && parseMs > 0.0) {
+        ss << "     Parsed " << std::fixed << std::setprecision(1) << parsedBytes / (1024.0 * 1024.0) << " MB in " << std::setprecision(2) << parseMs
+           << " ms (" << std::setprecision(0) << parsedBytes / (1024.0 * 1024.0) / (parseMs / 1000.0) << " MB/s)\n";
+    }
+    ss << "     Materials: " << materials.size() << " (" << sourceMaterials.size() << " in the MTL files)\n";
+    ss << "     Welded vertices: " << uniqueVertices << " in " << std::fixed << std::setprecision(2) << weldMs << " ms";
     
     logMessage(3, "Successfully loaded model: " + filepath, {"Graphics", "Model"});
     logMessage(4, ss.str(), {"Graphics", "Model"});
+
+    // the meshes hold everything drawn, the raw arrays are usually just memory
+    if (!options.keepAttrib) {
+        attrib = tinyobj::attrib_t();
+    }
+
+    if (options.generateNormals) {
+        buildNormals();
+    }
+    if (options.optimizeMeshes) {
+        optimizeMeshes();
+    }
+    // after the vertex fetch reorder, nothing later moves vertices
+    if (options.generateTangents) {
+        buildTangents();
+    }
+    buildLods();
+    if (options.buildMeshlets) {
+        buildMeshlets();
+    }
+
+    if (!cachePath.empty()) {
+        if (MeshCache::write(cachePath, sourceSize, sourceHash, cacheSettings(), meshes, materials)) {
+            logMessage(4, "Wrote mesh cache: " + cachePath, {"Graphics", "Model"});
+        } else {
+            logMessage(2, "Failed to write mesh cache: " + cachePath, {"Graphics", "Model"});
+        }
+    }
     return true;
 }
+
+void Model::buildMaterials(const std::vector<tinyobj::material_t>& sourceMaterials, const std::vector<tinyobj::shape_t>& shapes,
+                           std::vector<uint32_t>& materialRemap) {
+    materials.clear();
+    materialRemap.clear();
+    for (const tinyobj::material_t& source : sourceMaterials) {
+        materialRemap.push_back(addMaterial(materials, toModelMaterial(source)));
+    }
+
+    // faces without a usemtl (id -1) share a default material, kept last in the remap
+    bool needsDefault = materials.empty();
+    for (const auto& shape : shapes) {
+        needsDefault = needsDefault || shape.mesh.material_ids.size() < shape.mesh.num_face_vertices.size();
+        for (int materialId : shape.mesh.material_ids) {
+            if (materialId < 0 || static_cast<size_t>(materialId) >= sourceMaterials.size()) {
+                needsDefault = true;
+                break;
+            }
+        }
+    }
+    uint32_t defaultMaterial = 0;
+    if (needsDefault) {
+        ModelMaterial material;
+        material.name = "default";
+        defaultMaterial = addMaterial(materials, std::move(material));
+    }
+    materialRemap.push_back(defaultMaterial);
+}
+
+void Model::buildMesh(const tinyobj::shape_t& shape, const std::vector<uint32_t>& materialRemap, Mesh& mesh) const {
+    weldShape(shape, mesh);
+
+    // faces are triangles here, both parsers triangulate
+    size_t triangleCount = mesh.indices.size() / 3;
+    std::vector<uint32_t> triangleMaterial(triangleCount);
+    std::vector<uint32_t> materialStart(materials.size() + 1, 0);
+    size_t sourceCount = materialRemap.size() - 1;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        int materialId = t < shape.mesh.material_ids.size() ? shape.mesh.material_ids[t] : -1;
+        triangleMaterial[t] = materialId >= 0 && static_cast<size_t>(materialId) < sourceCount ? materialRemap[materialId] : materialRemap.back();
+        ++materialStart[triangleMaterial[t] + 1];
+    }
+    for (size_t m = 0; m < materials.size(); ++m) {
+        materialStart[m + 1] += materialStart[m];
+    }
+
+    // stable counting sort of the triangles by material, one submesh per used material
+    size_t usedMaterials = 0;
+    for (size_t m = 0; m < materials.size(); ++m) {
+        if (materialStart[m + 1] != materialStart[m]) {
+            mesh.submeshes.push_back(Submesh{materialStart[m] * 3, (materialStart[m + 1] - materialStart[m]) * 3, static_cast<uint32_t>(m)});
+            ++usedMaterials;
+        }
+    }
+    if (usedMaterials < 2) {
+        return;
+    }
+    std::vector<uint32_t> sorted(mesh.indices.size());
+    for (size_t t = 0; t < triangleCount; ++t) {
+        uint32_t target = materialStart[triangleMaterial[t]]++ * 3;
+        sorted[target] = mesh.indices[t * 3];
+        sorted[target + 1] = mesh.indices[t * 3 + 1];
+        sorted[target + 2] = mesh.indices[t * 3 + 2];
+    }
+    mesh.indices = std::move(sorted);
+}
+
+void Model::mergeMeshes() {
+    Mesh merged;
+    size_t vertexCount = 0, indexCount = 0;
+    for (const Mesh& mesh : meshes) {
+        vertexCount += mesh.vertices.size();
+        indexCount += mesh.indices.size();
+    }
+    merged.vertices.reserve(vertexCount);
+    merged.indices.reserve(indexCount);
+    std::vector<uint32_t> vertexBase(meshes.size());
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        vertexBase[i] = static_cast<uint32_t>(merged.vertices.size());
+        merged.vertices.insert(merged.vertices.end(), meshes[i].vertices.begin(), meshes[i].vertices.end());
+    }
+
+    // the ranges of one material from every shape go back to back into a single submesh,
+    // vertices on the seams between shapes stay duplicated
+    for (uint32_t material = 0; material < materials.size(); ++material) {
+        Submesh submesh{static_cast<uint32_t>(merged.indices.size()), 0, material};
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            for (const Submesh& range : meshes[i].submeshes) {
+                if (range.material != material) {
+                    continue;
+                }
+                for (uint32_t k = range.indexOffset; k < range.indexOffset + range.indexCount; ++k) {
+                    merged.indices.push_back(meshes[i].indices[k] + vertexBase[i]);
+                }
+            }
+        }
+        submesh.indexCount = static_cast<uint32_t>(merged.indices.size()) - submesh.indexOffset;
+        if (submesh.indexCount != 0) {
+            merged.submeshes.push_back(submesh);
+        }
+    }
+    meshes.clear();
+    if (!merged.indices.empty()) {
+        meshes.push_back(std::move(merged));
+    }
+}
+
+void Model::weldShape(const tinyobj::shape_t& shape, Mesh& mesh) const {
+    size_t cornerCount = 0;
+    for (unsigned int faceVertices : shape.mesh.num_face_vertices) {
+        cornerCount += faceVertices;
+    }
+    const tinyobj::index_t* corners = shape.mesh.indices.data();
+
+    ThreadPool& pool = ThreadPool::shared();
+    size_t chunkCount = std::min(pool.threadCount() + 1, cornerCount / kParallelWeldCorners);
+    if (chunkCount < 2) {
+        weldCorners(attrib, corners, corners + cornerCount, mesh.vertices, mesh.indices);
+        return;
+    }
+
+    // large shapes are welded in contiguous chunks first, then the chunks are merged
+    // in file order, which hands out the same first use order as a single pass
+    // while the serial merge only sees each chunk's unique vertices
+    struct WeldChunk {
+        size_t begin = 0;
+        size_t end = 0;
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<uint32_t> remap;
+    };
+    std::vector<WeldChunk> chunks(chunkCount);
+    pool.parallelFor(chunkCount, [&](size_t chunkIndex) {
+        WeldChunk& chunk = chunks[chunkIndex];
+        chunk.begin = cornerCount * chunkIndex / chunkCount;
+        chunk.end = cornerCount * (chunkIndex + 1) / chunkCount;
+        weldCorners(attrib, corners + chunk.begin, corners + chunk.end, chunk.vertices, chunk.indices);
+    });
+
+    size_t chunkVertexCount = 0;
+    for (const WeldChunk& chunk : chunks) {
+        chunkVertexCount += chunk.vertices.size();
+    }
+    mesh.vertices.reserve(chunkVertexCount);
+    VertexWeldTable<Vertex> uniqueVertices(mesh.vertices, chunkVertexCount);
+    for (WeldChunk& chunk : chunks) {
+        chunk.remap.resize(chunk.vertices.size());
+        for (size_t i = 0; i < chunk.vertices.size(); ++i) {
+            chunk.remap[i] = uniqueVertices.weld(chunk.vertices[i]);
+        }
+    }
+    mesh.vertices.shrink_to_fit();
+
+    mesh.indices.resize(cornerCount);
+    pool.parallelFor(chunkCount, [&](size_t chunkIndex) {
+        const WeldChunk& chunk = chunks[chunkIndex];
+        for (size_t i = 0; i < chunk.indices.size(); ++i) {
+            mesh.indices[chunk.begin + i] = chunk.remap[chunk.indices[i]];
+        }
+    });
+}
+
+void Model::optimizeMeshes() {
+    auto optimizeStart = std::chrono::steady_clock::now();
+    std::vector<VertexCacheStats> before(meshes.size());
+    std::vector<VertexCacheStats> after(meshes.size());
+    ThreadPool::shared().parallelFor(meshes.size(), [&](size_t meshIndex) {
+        Mesh& mesh = meshes[meshIndex];
+        before[meshIndex] = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+        optimizeMesh(mesh);
+        after[meshIndex] = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+    });
+    double optimizeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - optimizeStart).count();
+
+    // per model figures, ACMR weighted by triangles and ATVR by vertices
+    double triangles = 0.0, vertices = 0.0;
+    double acmrBefore = 0.0, acmrAfter = 0.0, atvrBefore = 0.0, atvrAfter = 0.0;
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        double meshTriangles = static_cast<double>(meshes[i].indices.size() / 3);
+        double meshVertices = static_cast<double>(meshes[i].vertices.size());
+        triangles += meshTriangles;
+        vertices += meshVertices;
+        acmrBefore += before[i].acmr * meshTriangles;
+        acmrAfter += after[i].acmr * meshTriangles;
+        atvrBefore += before[i].atvr * meshVertices;
+        atvrAfter += after[i].atvr * meshVertices;
+    }
+    if (triangles > 0.0 && vertices > 0.0) {
+        logMessage(4, logFormat("     Vertex cache ACMR ", std::fixed, std::setprecision(3), acmrBefore / triangles, " -> ", acmrAfter / triangles,
+                                ", ATVR ", atvrBefore / vertices, " -> ", atvrAfter / vertices, " (optimized in ", std::setprecision(2), optimizeMs, " ms)"),
+                   {"Graphics", "Model"});
+    }
+}
+
+void Model::buildNormals() {
+    auto normalStart = std::chrono::steady_clock::now();
+    std::vector<uint8_t> generated(meshes.size(), 0);
+    ThreadPool::shared().parallelFor(meshes.size(), [&](size_t meshIndex) {
+        generated[meshIndex] = generateNormals(meshes[meshIndex]) ? 1 : 0;
+    });
+    double normalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - normalStart).count();
+
+    size_t generatedCount = std::count(generated.begin(), generated.end(), uint8_t(1));
+    if (generatedCount > 0) {
+        logMessage(4, logFormat("     Generated normals for ", generatedCount, " of ", meshes.size(), " meshes in ", std::fixed, std::setprecision(2), normalMs, " ms"),
+                   {"Graphics", "Model"});
+    }
+}
+
+void Model::buildTangents() {
+    auto tangentStart = std::chrono::steady_clock::now();
+    std::vector<uint8_t> generated(meshes.size(), 0);
+    ThreadPool::shared().parallelFor(meshes.size(), [&](size_t meshIndex) {
+        generated[meshIndex] = generateTangents(meshes[meshIndex]) ? 1 : 0;
+    });
+    double tangentMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - tangentStart).count();
+
+    size_t generatedCount = std::count(generated.begin(), generated.end(), uint8_t(1));
+    if (generatedCount > 0) {
+        logMessage(4, logFormat("     Generated tangents for ", generatedCount, " of ", meshes.size(), " meshes in ", std::fixed, std::setprecision(2), tangentMs, " ms"),
+                   {"Graphics", "Model"});
+    }
+}
+
+MeshCacheSettings Model::cacheSettings() const {
+    MeshCacheSettings settings;
+    settings.flags = (options.optimizeMeshes ? kMeshCacheOptimized : 0) | (options.buildMeshlets ? kMeshCacheMeshlets : 0) |
+                     (options.mergeShapes ? kMeshCacheMergedShapes : 0) | (options.generateNormals ? kMeshCacheNormals : 0) |
+                     (options.generateTangents ? kMeshCacheTangents : 0);
+    settings.lodLevels = options.lodLevels;
+    if (options.lodLevels != 0) {
+        settings.lodReduction = options.lodReduction;
+        settings.lodMaxError = options.lodMaxError;
+    }
+    return settings;
+}
+
+void Model::packMeshes() {
+    ThreadPool::shared().parallelFor(meshes.size(), [&](size_t meshIndex) {
+        meshes[meshIndex].packed = packMesh(meshes[meshIndex], options.quantizePositions, options.splitStreams);
+    });
+
+    size_t fullBytes = 0, packedBytes = 0, shortIndexMeshes = 0;
+    for (const auto& mesh : meshes) {
+        fullBytes += mesh.vertices.size() * sizeof(Vertex) + mesh.indices.size() * sizeof(uint32_t);
+        packedBytes += mesh.packed.byteSize();
+        shortIndexMeshes += mesh.packed.uses16BitIndices() ? 1 : 0;
+    }
+    if (fullBytes > 0) {
+        logMessage(4, logFormat("     Packed vertices: ", fullBytes / 1024, " KB -> ", packedBytes / 1024, " KB (", std::fixed, std::setprecision(1),
+                                100.0 * (1.0 - double(packedBytes) / double(fullBytes)), "% smaller), ", shortIndexMeshes, " of ", meshes.size(),
+                                " meshes with 16 bit indices"),
+                   {"Graphics", "Model"});
+    }
+}
+
+void Model::splitMeshStreams() {
+    ThreadPool::shared().parallelFor(meshes.size(), [&](size_t meshIndex) {
+        buildVertexStreams(meshes[meshIndex]);
+    });
+}
+
+void Model::computeBounds() {
+    ThreadPool::shared().parallelFor(meshes.size(), [&](size_t meshIndex) {
+        Mesh& mesh = meshes[meshIndex];
+        const glm::vec3* positions = mesh.vertices.empty() ? nullptr : &mesh.vertices[0].position;
+        mesh.bounds = computeAabb(positions, mesh.vertices.size(), sizeof(Vertex));
+        mesh.sphere = computeBoundingSphere(positions, mesh.vertices.size(), sizeof(Vertex), mesh.bounds);
+    });
+    bounds = Aabb();
+    for (const auto& mesh : meshes) {
+        bounds.grow(mesh.bounds);
+    }
+}
+
+void buildVertexStreams(Mesh& mesh) {
+    mesh.positions.resize(mesh.vertices.size());
+    mesh.attributes.resize(mesh.vertices.size());
+    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+        const Vertex& vertex = mesh.vertices[i];
+        mesh.positions[i] = vertex.position;
+        mesh.attributes[i] = VertexAttributes{vertex.normal, vertex.texCoord, vertex.color};
+    }
+}
+
+void Model::buildLods() {
+    auto lodStart = std::chrono::steady_clock::now();
+    ThreadPool::shared().parallelFor(meshes.size(), [&](size_t meshIndex) {
+        generateLods(meshes[meshIndex], options.lodLevels, options.lodReduction, options.lodMaxError);
+    });
+    if (options.lodLevels == 0) {
+        return;
+    }
+    double lodMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - lodStart).count();
+
+    // triangles and error of each level summed over the meshes that have it
+    std::vector<size_t> levelTriangles;
+    std::vector<float> levelError;
+    for (const auto& mesh : meshes) {
+        for (size_t level = 0; level < mesh.lods.size(); ++level) {
+            if (level >= levelTriangles.size()) {
+                levelTriangles.push_back(0);
+                levelError.push_back(0.0f);
+            }
+            levelTriangles[level] += mesh.lods[level].indexCount / 3;
+            levelError[level] = std::max(levelError[level], mesh.lods[level].error);
+        }
+    }
+    std::stringstream ss;
+    ss << "     LODs:";
+    for (size_t level = 0; level < levelTriangles.size(); ++level) {
+        ss << (level == 0 ? " " : " / ") << levelTriangles[level] << " tris";
+        if (level != 0) {
+            ss << " (error " << std::setprecision(3) << levelError[level] << ")";
+        }
+    }
+    ss << " in " << std::fixed << std::setprecision(2) << lodMs << " ms";
+    logMessage(4, ss.str(), {"Graphics", "Model"});
+}
+
+void Model::buildMeshlets() {
+    auto meshletStart = std::chrono::steady_clock::now();
+    ThreadPool::shared().parallelFor(meshes.size(), [&](size_t meshIndex) {
+        generateMeshlets(meshes[meshIndex]);
+    });
+    double meshletMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - meshletStart).count();
+
+    size_t meshletCount = 0, vertexCount = 0, triangleCount = 0;
+    for (const auto& mesh : meshes) {
+        meshletCount += mesh.meshlets.size();
+        for (const Meshlet& meshlet : mesh.meshlets) {
+            vertexCount += meshlet.vertexCount;
+            triangleCount += meshlet.triangleCount;
+        }
+    }
+    if (meshletCount > 0) {
+        logMessage(4, logFormat("     Meshlets: ", meshletCount, " (", std::fixed, std::setprecision(1), double(vertexCount) / meshletCount, " vertices, ",
+                                double(triangleCount) / meshletCount, " triangles on average) in ", std::setprecision(2), meshletMs, " ms"),
+                   {"Graphics", "Model"});
+    }
+}
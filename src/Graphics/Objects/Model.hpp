@@ -3,11 +3,14 @@
 
 
 
+#include <string>
 #include <tiny_obj_loader.h>
 #include <vector>
 #include <glm/glm.hpp>
-#include <functional>
 
+#include "Bounds.hpp"
+#include "Meshlet.hpp"
+#include "PackedMesh.hpp"
 #include "Utils/Utils.hpp"
 
 struct Vertex {
@@ -16,56 +19,180 @@ struct Vertex {
     glm::vec2 texCoord;
     glm::vec3 color;
 
+    // welding (VertexWeldTable) compares the raw bytes, keep this struct free of padding
     bool operator==(const Vertex& other) const {
         return position == other.position && normal == other.normal && texCoord == other.texCoord && color == other.color;
     }
 };
+static_assert(sizeof(Vertex) == 11 * sizeof(float), "Vertex must stay tightly packed for byte wise welding");
 
-namespace std
-{
-    template <>
-    struct hash<Vertex>
-    {
-        size_t operator()(Vertex const &v) const noexcept
-        {
-            auto h = size_t{0};
-            auto mix = [](size_t seed, size_t v) noexcept
-            {
-                seed ^= v + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
-                return seed;
-            };
-            // hash floats from position, normal, texCoord
-            h = mix(h, std::hash<float>{}(v.position.x));
-            h = mix(h, std::hash<float>{}(v.position.y));
-            h = mix(h, std::hash<float>{}(v.position.z));
-            h = mix(h, std::hash<float>{}(v.normal.x));
-            h = mix(h, std::hash<float>{}(v.normal.y));
-            h = mix(h, std::hash<float>{}(v.normal.z));
-            h = mix(h, std::hash<float>{}(v.texCoord.x));
-            h = mix(h, std::hash<float>{}(v.texCoord.y));
-            h = mix(h, std::hash<float>{}(v.color.x));
-            h = mix(h, std::hash<float>{}(v.color.y));
-            h = mix(h, std::hash<float>{}(v.color.z));
-            return h;
-        }
-    };
-}
+// everything in Vertex but the position, the second stream of a de-interleaved mesh
+struct VertexAttributes {
+    glm::vec3 normal;
+    glm::vec2 texCoord;
+    glm::vec3 color;
+};
+
+// one material's triangles inside a level of detail, drawn with a single call
+struct Submesh {
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    uint32_t material;  // index into Model::getMaterials()
+};
+
+// one level of detail, a range of Mesh::indices drawn with the shared vertex buffer
+struct MeshLod {
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    float error;  // object space distance from the full mesh, see MeshLod.hpp
+    // its material ranges, Mesh::submeshes[submeshOffset .. + submeshCount) in material order
+    uint32_t submeshOffset;
+    uint32_t submeshCount;
+};
+
+// material parameters of the MTL file, the renderer binds one per Submesh
+struct ModelMaterial {
+    std::string name;
+    glm::vec3 ambient = glm::vec3(0.0f);
+    glm::vec3 diffuse = glm::vec3(1.0f);
+    glm::vec3 specular = glm::vec3(0.0f);
+    glm::vec3 emission = glm::vec3(0.0f);
+    float shininess = 1.0f;
+    float dissolve = 1.0f;
+    float ior = 1.0f;
+    int illum = 0;
+    // texture paths as written in the MTL file, empty when unused
+    std::string diffuseTexture;
+    std::string specularTexture;
+    std::string normalTexture;
+    std::string alphaTexture;
+
+    // everything but the name, materials that draw the same are merged on load
+    bool drawsLike(const ModelMaterial& other) const {
+        return ambient == other.ambient && diffuse == other.diffuse && specular == other.specular && emission == other.emission &&
+               shininess == other.shininess && dissolve == other.dissolve && ior == other.ior && illum == other.illum &&
+               diffuseTexture == other.diffuseTexture && specularTexture == other.specularTexture && normalTexture == other.normalTexture &&
+               alphaTexture == other.alphaTexture;
+    }
+};
 
 struct Mesh {
     std::vector<Vertex> vertices;
+    // every level of detail back to back, lods[0] is the full mesh and starts at 0
     std::vector<uint32_t> indices;
+    std::vector<MeshLod> lods;
+    // triangles of every level are sorted by material, each run is one entry here
+    std::vector<Submesh> submeshes;
+    // object space bounds of vertices, computed on every load (cache hits included)
+    Aabb bounds;
+    BoundingSphere sphere;
+    // xyz tangent along increasing u, bitangent = w * cross(normal, tangent), same order and
+    // count as vertices, empty unless ModelOptions::generateTangents and the mesh has uvs
+    std::vector<glm::vec4> tangents;
+    // de-interleaved copies of vertices, same order and count, empty unless ModelOptions::splitStreams
+    // depth only passes and CPU work (bounds, culling) read positions alone, 12 bytes a vertex instead of 44
+    std::vector<glm::vec3> positions;
+    std::vector<VertexAttributes> attributes;
+    // vertex fetch friendly copy for upload, empty unless ModelOptions::packVertices
+    PackedMesh packed;
+    // clusters of lods[0] for culling, empty unless ModelOptions::buildMeshlets, see Meshlet.hpp
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> meshletVertices;  // indices into vertices
+    std::vector<uint8_t> meshletTriangles;  // indices into each meshlet's meshletVertices range
+
+    bool hasStreams() const { return !positions.empty() && positions.size() == vertices.size(); }
+};
+
+// the ModelOptions that change cooked meshes, a cache written with other settings is stale
+struct MeshCacheSettings {
+    uint32_t flags = 0;  // kMeshCache* bits
+    uint32_t lodLevels = 0;
+    float lodReduction = 0.0f;
+    float lodMaxError = 0.0f;
+
+    bool operator==(const MeshCacheSettings& other) const {
+        return flags == other.flags && lodLevels == other.lodLevels && lodReduction == other.lodReduction && lodMaxError == other.lodMaxError;
+    }
+};
+
+// fills mesh.positions and mesh.attributes from mesh.vertices
+void buildVertexStreams(Mesh& mesh);
+
+struct ModelOptions {
+    // parse with ObjParser (memory mapped, multithreaded) instead of tinyobj::LoadObj
+    bool nativeObjParser = true;
+    // keep the parsed tinyobj::attrib_t for getAttrib() after the meshes are built
+    bool keepAttrib = false;
+    // reuse the cooked meshes in cacheDirectory when the OBJ is unchanged, see MeshCache.hpp
+    bool useMeshCache = true;
+    std::string cacheDirectory = "cache/meshes";
+    // smooth angle weighted normals for vertices the OBJ has none for, see MeshTangents.hpp
+    bool generateNormals = true;
+    // MikkTSpace style tangents (Mesh::tangents) for meshes with uvs
+    bool generateTangents = true;
+    // reorder triangles and vertices for the post transform cache, overdraw and fetch, see MeshOptimizer.hpp
+    bool optimizeMeshes = true;
+    // build Mesh::packed next to the full vertices, layout is chosen per mesh, see PackedMesh.hpp
+    // off by default: nothing uploads the packed copy yet, so it only doubles vertex memory
+    bool packVertices = false;
+    // allow 16 bit positions relative to the mesh bounds in the packed layout
+    bool quantizePositions = true;
+    // also expose positions and attributes as separate streams (Mesh::positions, Mesh::attributes
+    // and a separate position buffer in Mesh::packed) for position only passes
+    bool splitStreams = false;
+    // coarser index ranges built per mesh by quadric simplification, see MeshLod.hpp
+    unsigned int lodLevels = 3;
+    // triangle count of each level relative to the one before
+    float lodReduction = 0.5f;
+    // largest simplification error allowed, relative to the mesh bounds radius
+    float lodMaxError = 0.05f;
+    // split each mesh into meshlets with bounds and normal cones for cluster culling, see Meshlet.hpp
+    bool buildMeshlets = true;
+    // merge all shapes into one mesh so each material is a single range for the whole model,
+    // fewer draws when the shapes never need their own transform or visibility
+    bool mergeShapes = false;
 };
 
 class Model {
 public:
-    Model(const std::string& filepath);
+    Model(const std::string& filepath, const ModelOptions& options = ModelOptions());
+    // false when the file could not be read or parsed, the model then has no meshes
+    bool isLoaded() const { return loaded; }
     const std::vector<Mesh>& getMeshes() const { return meshes; }
+    // Submesh::material indexes this, never empty once loaded (faces without a
+    // material use a default one), materials that draw the same are listed once
+    const std::vector<ModelMaterial>& getMaterials() const { return materials; }
+    // union of the mesh bounds
+    const Aabb& getBounds() const { return bounds; }
+    // empty unless ModelOptions::keepAttrib, and when the meshes came from the mesh cache
     const tinyobj::attrib_t& getAttrib() const { return attrib; }
 
 private:
+    ModelOptions options;
+    bool loaded = false;
     std::vector<Mesh> meshes;
+    std::vector<ModelMaterial> materials;
+    Aabb bounds;
     tinyobj::attrib_t attrib;
     bool loadOBJ(const std::string& filepath);
+    // fills materials from the MTL ones, materialRemap maps a tinyobj material id to its entry
+    void buildMaterials(const std::vector<tinyobj::material_t>& sourceMaterials, const std::vector<tinyobj::shape_t>& shapes,
+                        std::vector<uint32_t>& materialRemap);
+    // welds one shape into mesh and sorts its triangles by material, only reads attrib so
+    // shapes can be built in parallel
+    void buildMesh(const tinyobj::shape_t& shape, const std::vector<uint32_t>& materialRemap, Mesh& mesh) const;
+    void weldShape(const tinyobj::shape_t& shape, Mesh& mesh) const;
+    // one mesh for the whole model with a single range per material, see ModelOptions::mergeShapes
+    void mergeMeshes();
+    void buildNormals();
+    void buildTangents();
+    void optimizeMeshes();
+    void buildLods();
+    void buildMeshlets();
+    void packMeshes();
+    void splitMeshStreams();
+    void computeBounds();
+    MeshCacheSettings cacheSettings() const;
 };
 
 #endif // MODEL_HPP
@@ -0,0 +1,119 @@
+#include "ModelLoader.hpp"
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+#include "Utils/ThreadPool.hpp"
+
+namespace
+{
+    // loads mostly wait on the disk before their parallel stages start, two let one
+    // model parse while the next one is being read without crowding the shared pool
+    constexpr size_t kLoaderThreads = 2;
+
+    ThreadPool& loaderPool() {
+        // loads fan out onto the shared pool, constructing it first makes it outlive this one
+        ThreadPool::shared();
+        static ThreadPool pool(kLoaderThreads);
+        return pool;
+    }
+
+    struct PendingCallback {
+        ModelHandle handle;
+        ModelLoadCallback callback;
+    };
+
+    std::mutex callbackMutex;
+    std::deque<PendingCallback> pendingCallbacks;
+}
+
+struct ModelHandle::Load {
+    std::string path;
+    std::promise<std::shared_ptr<const Model>> promise;
+    std::shared_future<std::shared_ptr<const Model>> future = promise.get_future().share();
+};
+
+ModelLoadState ModelHandle::state() const {
+    if (!load_) {
+        return ModelLoadState::Empty;
+    }
+    if (load_->future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return ModelLoadState::Loading;
+    }
+    return load_->future.get() ? ModelLoadState::Ready : ModelLoadState::Failed;
+}
+
+bool ModelHandle::done() const {
+    ModelLoadState current = state();
+    return current == ModelLoadState::Ready || current == ModelLoadState::Failed;
+}
+
+void ModelHandle::wait() const {
+    if (load_) {
+        load_->future.wait();
+    }
+}
+
+std::shared_ptr<const Model> ModelHandle::model() const {
+    return ready() ? load_->future.get() : nullptr;
+}
+
+const std::string& ModelHandle::path() const {
+    static const std::string empty;
+    return load_ ? load_->path : empty;
+}
+
+std::shared_future<std::shared_ptr<const Model>> ModelHandle::future() const {
+    return load_ ? load_->future : std::shared_future<std::shared_ptr<const Model>>();
+}
+
+ModelHandle loadModelAsync(const std::string& filepath, const ModelOptions& options, ModelLoadCallback onLoaded) {
+    ModelHandle handle;
+    handle.load_ = std::make_shared<ModelHandle::Load>();
+    handle.load_->path = filepath;
+
+    loaderPool().submit([handle, options, onLoaded = std::move(onLoaded)]() {
+        auto loadStart = std::chrono::steady_clock::now();
+        std::shared_ptr<const Model> model;
+        try {
+            auto loadedModel = std::make_shared<Model>(handle.path(), options);
+            if (loadedModel->isLoaded()) {
+                model = std::move(loadedModel);
+            }
+        } catch (const std::exception& exception) {
+            logMessage(1, "Exception while loading model " + handle.path() + ": " + exception.what(), {"Graphics", "Model"});
+        }
+        double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+        logMessage(4, logFormat("     Background load of ", handle.path(), model ? " finished" : " failed", " in ", std::fixed, std::setprecision(2), loadMs, " ms"),
+                   {"Graphics", "Model"});
+
+        // the future is ready before the callback is queued, so callbacks always see the model
+        handle.load_->promise.set_value(std::move(model));
+        if (onLoaded) {
+            std::lock_guard<std::mutex> lock(callbackMutex);
+            pendingCallbacks.push_back({handle, onLoaded});
+        }
+    });
+    return handle;
+}
+
+size_t dispatchModelCallbacks(size_t maxCallbacks) {
+    size_t dispatched = 0;
+    while (dispatched < maxCallbacks) {
+        PendingCallback pending;
+        {
+            std::lock_guard<std::mutex> lock(callbackMutex);
+            if (pendingCallbacks.empty()) {
+                break;
+            }
+            pending = std::move(pendingCallbacks.front());
+            pendingCallbacks.pop_front();
+        }
+        // run outside the lock, callbacks may start new loads
+        pending.callback(pending.handle);
+        ++dispatched;
+    }
+    return dispatched;
+}
@@ -0,0 +1,62 @@
+#ifndef MODELLOADER_HPP
+#define MODELLOADER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+
+#include "Model.hpp"
+
+// background model loading so the frame loop never waits on file I/O or parsing
+//
+// loadModelAsync returns at once, the load runs on a small loader pool and fans its
+// parallel stages (welding, optimizing, LODs) out to ThreadPool::shared()
+// completion callbacks are queued and only run inside dispatchModelCallbacks, call it
+// once a frame from the main thread so callbacks can touch renderer state safely
+
+enum class ModelLoadState {
+    Empty,    // default constructed handle, no load behind it
+    Loading,
+    Ready,
+    Failed
+};
+
+class ModelHandle {
+public:
+    ModelHandle() = default;
+
+    // non-blocking, Loading until the model is built
+    ModelLoadState state() const;
+    bool ready() const { return state() == ModelLoadState::Ready; }
+    // true once the load finished, whether it worked or not
+    bool done() const;
+    // blocks until done, only for loading screens and shutdown, never inside the frame loop
+    void wait() const;
+
+    // null until ready, and for failed loads
+    std::shared_ptr<const Model> model() const;
+    const std::string& path() const;
+    // resolves to the model, or null when the load failed
+    std::shared_future<std::shared_ptr<const Model>> future() const;
+
+    explicit operator bool() const { return load_ != nullptr; }
+
+private:
+    friend ModelHandle loadModelAsync(const std::string&, const ModelOptions&, std::function<void(const ModelHandle&)>);
+    struct Load;
+    std::shared_ptr<Load> load_;
+};
+
+using ModelLoadCallback = std::function<void(const ModelHandle&)>;
+
+// starts loading filepath in the background, onLoaded (if any) is queued for
+// dispatchModelCallbacks when the load finishes, failed or not
+ModelHandle loadModelAsync(const std::string& filepath, const ModelOptions& options = ModelOptions(), ModelLoadCallback onLoaded = nullptr);
+
+// runs up to maxCallbacks queued completion callbacks on the calling thread, returns how many ran
+size_t dispatchModelCallbacks(size_t maxCallbacks = SIZE_MAX);
+
+#endif // MODELLOADER_HPP
@@ -0,0 +1,497 @@
+#include "ObjParser.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+#include "Utils/ThreadPool.hpp"
+
+namespace
+{
+    // chunks below this are not worth a pool task
+    constexpr size_t kMinChunkBytes = 1 << 20;
+    // more chunks than threads so uneven chunks (comments, long faces) still balance
+    constexpr size_t kChunksPerThread = 4;
+
+    // powers of ten a double holds exactly, mantissa * 10^e is then correctly rounded
+    constexpr double kPow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    constexpr int kMaxExactPow10 = 22;
+    constexpr uint64_t kMaxExactMantissa = 1ull << 53;
+
+    enum CornerAttribute { kCornerVertex = 0, kCornerTexCoord = 1, kCornerNormal = 2 };
+
+    struct ObjEvent {
+        enum Kind { Group, Material, MaterialLibrary } kind;
+        size_t triangle;  // first triangle the event applies to, chunk local
+        std::string name;
+    };
+
+    // everything one chunk of lines produced, indices still chunk local where the OBJ used
+    // relative (negative) ones, those corners are listed in relativeCorners
+    struct ObjChunk {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        std::vector<float> positions;
+        std::vector<float> colors;  // three per position, white when the line had none
+        std::vector<float> normals;
+        std::vector<float> texCoords;
+        bool hasColors = false;
+        std::vector<tinyobj::index_t> corners;  // three per triangle
+        std::vector<size_t> relativeCorners;    // corner * 3 + CornerAttribute
+        std::vector<ObjEvent> events;
+        std::string error;
+        size_t errorLine = 0;  // chunk local
+    };
+
+    bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    const char* skipSpaces(const char* p, const char* end) {
+        while (p < end && (*p == ' ' || *p == '\t')) {
+            ++p;
+        }
+        return p;
+    }
+
+    // rest of the line without surrounding spaces
+    std::string restOfLine(const char* p, const char* end) {
+        p = skipSpaces(p, end);
+        while (end > p && (end[-1] == ' ' || end[-1] == '\t')) {
+            --end;
+        }
+        return std::string(p, end);
+    }
+
+    bool parseIndex(const char*& p, const char* end, int& value) {
+        bool negative = p < end && *p == '-';
+        const char* digits = negative ? p + 1 : p;
+        if (digits >= end || !isDigit(*digits)) {
+            return false;
+        }
+        int64_t result = 0;
+        for (; digits < end && isDigit(*digits); ++digits) {
+            result = std::min<int64_t>(result * 10 + (*digits - '0'), INT32_MAX);
+        }
+        value = static_cast<int>(negative ? -result : result);
+        p = digits;
+        return true;
+    }
+
+    struct PolygonCorner {
+        tinyobj::index_t index;
+        uint8_t relative;  // bit per CornerAttribute that still needs the chunk's base
+    };
+
+    // OBJ indices are 1 based from the start or negative from the end of what was read so far,
+    // negative ones are made chunk local here and rebased at the merge
+    bool resolveIndex(int raw, size_t localCount, int attribute, PolygonCorner& corner, int& index) {
+        if (raw > 0) {
+            index = raw - 1;
+            return true;
+        }
+        if (raw < 0) {
+            index = static_cast<int>(static_cast<int64_t>(localCount) + raw);
+            corner.relative |= static_cast<uint8_t>(1u << attribute);
+            return true;
+        }
+        return false;
+    }
+
+    bool parseFace(const char* p, const char* end, ObjChunk& chunk, std::vector<PolygonCorner>& polygon) {
+        polygon.clear();
+        size_t positionCount = chunk.positions.size() / 3;
+        size_t texCoordCount = chunk.texCoords.size() / 2;
+        size_t normalCount = chunk.normals.size() / 3;
+        for (;;) {
+            p = skipSpaces(p, end);
+            if (p >= end) {
+                break;
+            }
+            int raw[3] = {0, 0, 0};
+            if (!parseIndex(p, end, raw[0])) {
+                return false;
+            }
+            for (int attribute = 1; attribute < 3 && p < end && *p == '/'; ++attribute) {
+                ++p;
+                // v//vn leaves the texture coordinate empty
+                if (p < end && *p != '/' && *p != ' ' && *p != '\t' && !parseIndex(p, end, raw[attribute])) {
+                    return false;
+                }
+            }
+            if (p < end && *p != ' ' && *p != '\t') {
+                return false;
+            }
+            PolygonCorner corner{{-1, -1, -1}, 0};
+            if (!resolveIndex(raw[0], positionCount, kCornerVertex, corner, corner.index.vertex_index)) {
+                return false;
+            }
+            if (raw[1] != 0 && !resolveIndex(raw[1], texCoordCount, kCornerTexCoord, corner, corner.index.texcoord_index)) {
+                return false;
+            }
+            if (raw[2] != 0 && !resolveIndex(raw[2], normalCount, kCornerNormal, corner, corner.index.normal_index)) {
+                return false;
+            }
+            polygon.push_back(corner);
+        }
+        if (polygon.size() < 3) {
+            return false;
+        }
+
+        for (size_t i = 1; i + 1 < polygon.size(); ++i) {
+            for (size_t k : {size_t(0), i, i + 1}) {
+                for (int attribute = 0; attribute < 3; ++attribute) {
+                    if (polygon[k].relative & (1u << attribute)) {
+                        chunk.relativeCorners.push_back(chunk.corners.size() * 3 + attribute);
+                    }
+                }
+                chunk.corners.push_back(polygon[k].index);
+            }
+        }
+        return true;
+    }
+
+    // reads up to count floats, returns how many were there
+    size_t parseFloats(const char* p, const char* end, float* values, size_t count) {
+        size_t parsed = 0;
+        while (parsed < count) {
+            p = skipSpaces(p, end);
+            if (p >= end || !parseObjFloat(p, end, values[parsed])) {
+                break;
+            }
+            ++parsed;
+        }
+        return parsed;
+    }
+
+    void parseChunk(ObjChunk& chunk) {
+        std::vector<PolygonCorner> polygon;
+        size_t lineNumber = 0;
+        const char* line = chunk.begin;
+        while (line < chunk.end) {
+            const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(chunk.end - line)));
+            const char* next = lineEnd ? lineEnd + 1 : chunk.end;
+            if (!lineEnd) {
+                lineEnd = chunk.end;
+            }
+            if (lineEnd > line && lineEnd[-1] == '\r') {
+                --lineEnd;
+            }
+            ++lineNumber;
+
+            const char* p = skipSpaces(line, lineEnd);
+            line = next;
+            if (p >= lineEnd || *p == '#') {
+                continue;
+            }
+            // statement keyword, the rest of the line is its arguments
+            const char* keyword = p;
+            while (p < lineEnd && *p != ' ' && *p != '\t') {
+                ++p;
+            }
+            size_t keywordLength = static_cast<size_t>(p - keyword);
+            auto is = [&](const char* name) {
+                return std::strlen(name) == keywordLength && std::memcmp(keyword, name, keywordLength) == 0;
+            };
+
+            bool valid = true;
+            if (is("v")) {
+                // x y z, x y z w or x y z r g b
+                float values[6] = {0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+                size_t count = parseFloats(p, lineEnd, values, 6);
+                valid = count >= 3;
+                chunk.positions.insert(chunk.positions.end(), values, values + 3);
+                if (count == 6) {
+                    chunk.hasColors = true;
+                    chunk.colors.insert(chunk.colors.end(), values + 3, values + 6);
+                } else {
+                    chunk.colors.insert(chunk.colors.end(), {1.0f, 1.0f, 1.0f});
+                }
+            } else if (is("vn")) {
+                float values[3] = {0.0f, 0.0f, 0.0f};
+                valid = parseFloats(p, lineEnd, values, 3) == 3;
+                chunk.normals.insert(chunk.normals.end(), values, values + 3);
+            } else if (is("vt")) {
+                float values[2] = {0.0f, 0.0f};
+                valid = parseFloats(p, lineEnd, values, 2) >= 1;
+                chunk.texCoords.insert(chunk.texCoords.end(), values, values + 2);
+            } else if (is("f")) {
+                valid = parseFace(p, lineEnd, chunk, polygon);
+            } else if (is("o") || is("g")) {
+                chunk.events.push_back({ObjEvent::Group, chunk.corners.size() / 3, restOfLine(p, lineEnd)});
+            } else if (is("usemtl")) {
+                chunk.events.push_back({ObjEvent::Material, chunk.corners.size() / 3, restOfLine(p, lineEnd)});
+            } else if (is("mtllib")) {
+                chunk.events.push_back({ObjEvent::MaterialLibrary, chunk.corners.size() / 3, restOfLine(p, lineEnd)});
+            }
+            if (!valid) {
+                chunk.error = "malformed '" + std::string(keyword, keywordLength) + "' statement";
+                chunk.errorLine = lineNumber;
+                return;
+            }
+        }
+    }
+
+    void loadMaterialLibraries(const std::string& names, const std::string& materialDirectory, std::map<std::string, int>& materialMap,
+                               std::vector<tinyobj::material_t>& materials, std::string& warning) {
+        // several libraries may be listed on one line, tinyobj uses the first one that opens
+        const char* p = names.data();
+        const char* end = p + names.size();
+        while ((p = skipSpaces(p, end)) < end) {
+            const char* nameEnd = p;
+            while (nameEnd < end && *nameEnd != ' ' && *nameEnd != '\t') {
+                ++nameEnd;
+            }
+            std::string name(p, nameEnd);
+            p = nameEnd;
+
+            std::ifstream stream((std::filesystem::path(materialDirectory) / name).string());
+            if (!stream) {
+                continue;
+            }
+            std::string mtlWarning, mtlError;
+            tinyobj::LoadMtl(&materialMap, &materials, &stream, &mtlWarning, &mtlError);
+            warning += mtlWarning + mtlError;
+            return;
+        }
+        warning += "Material file(s) not found: " + names + "\n";
+    }
+}
+
+bool parseObjFloat(const char*& p, const char* end, float& value) {
+    const char* start = p;
+    const char* cursor = p;
+    bool negative = false;
+    if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+        negative = *cursor == '-';
+        ++cursor;
+    }
+
+    // up to 19 significant digits fit the mantissa, later ones only scale it
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool anyDigit = false;
+    for (; cursor < end && isDigit(*cursor); ++cursor) {
+        anyDigit = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*cursor - '0');
+            digits += mantissa != 0 ? 1 : 0;
+        } else {
+            ++exponent;
+        }
+    }
+    if (cursor < end && *cursor == '.') {
+        ++cursor;
+        for (; cursor < end && isDigit(*cursor); ++cursor) {
+            anyDigit = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*cursor - '0');
+                digits += mantissa != 0 ? 1 : 0;
+                --exponent;
+            }
+        }
+    }
+    if (!anyDigit) {
+        return false;
+    }
+    if (cursor < end && (*cursor == 'e' || *cursor == 'E')) {
+        const char* exponentStart = cursor + 1;
+        bool negativeExponent = false;
+        if (exponentStart < end && (*exponentStart == '-' || *exponentStart == '+')) {
+            negativeExponent = *exponentStart == '-';
+            ++exponentStart;
+        }
+        if (exponentStart < end && isDigit(*exponentStart)) {
+            int written = 0;
+            for (cursor = exponentStart; cursor < end && isDigit(*cursor); ++cursor) {
+                written = std::min(written * 10 + (*cursor - '0'), 100000);
+            }
+            exponent += negativeExponent ? -written : written;
+        }
+    }
+    p = cursor;
+
+    if (mantissa < kMaxExactMantissa && exponent >= -kMaxExactPow10 && exponent <= kMaxExactPow10) {
+        double result = static_cast<double>(mantissa);
+        result = exponent < 0 ? result / kPow10[-exponent] : result * kPow10[exponent];
+        value = static_cast<float>(negative ? -result : result);
+        return true;
+    }
+
+    // long mantissas and extreme exponents are rare, strtod gets them right
+    char buffer[128];
+    size_t length = std::min(static_cast<size_t>(cursor - start), sizeof(buffer) - 1);
+    std::memcpy(buffer, start, length);
+    buffer[length] = '\0';
+    value = static_cast<float>(std::strtod(buffer, nullptr));
+    return true;
+}
+
+bool parseObj(const char* text, size_t size, const std::string& materialDirectory, tinyobj::attrib_t& attrib,
+              std::vector<tinyobj::shape_t>& shapes, std::vector<tinyobj::material_t>& materials,
+              std::string& warning, std::string& error) {
+    attrib = tinyobj::attrib_t();
+    shapes.clear();
+    materials.clear();
+
+    // chunks start right after a newline so no line is split
+    ThreadPool& pool = ThreadPool::shared();
+    size_t chunkCount = std::clamp<size_t>(size / kMinChunkBytes, 1, (pool.threadCount() + 1) * kChunksPerThread);
+    std::vector<ObjChunk> chunks(chunkCount);
+    const char* end = text + size;
+    const char* previous = text;
+    for (size_t i = 0; i < chunkCount; ++i) {
+        const char* chunkEnd = end;
+        if (i + 1 < chunkCount) {
+            chunkEnd = std::max(previous, text + size * (i + 1) / chunkCount);
+            const char* newline = static_cast<const char*>(std::memchr(chunkEnd, '\n', static_cast<size_t>(end - chunkEnd)));
+            chunkEnd = newline ? newline + 1 : end;
+        }
+        chunks[i].begin = previous;
+        chunks[i].end = chunkEnd;
+        previous = chunkEnd;
+    }
+    pool.parallelFor(chunkCount, [&](size_t chunkIndex) {
+        parseChunk(chunks[chunkIndex]);
+    });
+
+    // chunk offsets into the merged arrays
+    std::vector<size_t> positionBase(chunkCount + 1, 0), normalBase(chunkCount + 1, 0), texCoordBase(chunkCount + 1, 0), cornerBase(chunkCount + 1, 0);
+    bool hasColors = false;
+    for (size_t i = 0; i < chunkCount; ++i) {
+        const ObjChunk& chunk = chunks[i];
+        if (!chunk.error.empty()) {
+            size_t line = chunk.errorLine + static_cast<size_t>(std::count(text, chunk.begin, '\n'));
+            error = chunk.error + " at line " + std::to_string(line);
+            return false;
+        }
+        positionBase[i + 1] = positionBase[i] + chunk.positions.size() / 3;
+        normalBase[i + 1] = normalBase[i] + chunk.normals.size() / 3;
+        texCoordBase[i + 1] = texCoordBase[i] + chunk.texCoords.size() / 2;
+        cornerBase[i + 1] = cornerBase[i] + chunk.corners.size();
+        hasColors = hasColors || chunk.hasColors;
+    }
+
+    attrib.vertices.resize(positionBase[chunkCount] * 3);
+    attrib.normals.resize(normalBase[chunkCount] * 3);
+    attrib.texcoords.resize(texCoordBase[chunkCount] * 2);
+    if (hasColors) {
+        attrib.colors.resize(positionBase[chunkCount] * 3);
+    }
+    std::vector<tinyobj::index_t> corners(cornerBase[chunkCount]);
+    std::vector<uint8_t> outOfRange(chunkCount, 0);
+    pool.parallelFor(chunkCount, [&](size_t chunkIndex) {
+        ObjChunk& chunk = chunks[chunkIndex];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), attrib.vertices.begin() + positionBase[chunkIndex] * 3);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), attrib.normals.begin() + normalBase[chunkIndex] * 3);
+        std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), attrib.texcoords.begin() + texCoordBase[chunkIndex] * 2);
+        if (hasColors) {
+            std::copy(chunk.colors.begin(), chunk.colors.end(), attrib.colors.begin() + positionBase[chunkIndex] * 3);
+        }
+        for (size_t relative : chunk.relativeCorners) {
+            tinyobj::index_t& corner = chunk.corners[relative / 3];
+            int* index;
+            switch (relative % 3) {
+            case kCornerVertex: index = &corner.vertex_index; *index += static_cast<int>(positionBase[chunkIndex]); break;
+            case kCornerTexCoord: index = &corner.texcoord_index; *index += static_cast<int>(texCoordBase[chunkIndex]); break;
+            default: index = &corner.normal_index; *index += static_cast<int>(normalBase[chunkIndex]); break;
+            }
+            // a relative index reaching before the first element, checked here because -1
+            // below means "no attribute" and would otherwise pass
+            if (*index < 0) {
+                outOfRange[chunkIndex] = 1;
+            }
+        }
+        // Model reads attrib through these without checks, so every index must be in range
+        int positionCount = static_cast<int>(positionBase[chunkCount]);
+        int texCoordCount = static_cast<int>(texCoordBase[chunkCount]);
+        int normalCount = static_cast<int>(normalBase[chunkCount]);
+        for (const tinyobj::index_t& corner : chunk.corners) {
+            if (corner.vertex_index < 0 || corner.vertex_index >= positionCount || corner.texcoord_index >= texCoordCount ||
+                corner.normal_index >= normalCount || corner.texcoord_index < -1 || corner.normal_index < -1) {
+                outOfRange[chunkIndex] = 1;
+                break;
+            }
+        }
+        std::copy(chunk.corners.begin(), chunk.corners.end(), corners.begin() + cornerBase[chunkIndex]);
+        // only the events are still needed, give the rest back before the shapes are copied
+        std::vector<ObjEvent> events = std::move(chunk.events);
+        chunk = ObjChunk();
+        chunk.events = std::move(events);
+    });
+    if (std::find(outOfRange.begin(), outOfRange.end(), 1) != outOfRange.end()) {
+        error = "face index out of range";
+        return false;
+    }
+
+    // events in file order split the triangles into shapes and give them materials
+    size_t triangleCount = corners.size() / 3;
+    std::vector<int> materialIds(triangleCount, -1);
+    std::map<std::string, int> materialMap;
+    std::string shapeName;
+    size_t shapeStart = 0, materialStart = 0;
+    int material = -1;
+    auto closeShape = [&](size_t triangle) {
+        if (triangle == shapeStart) {
+            return;
+        }
+        tinyobj::shape_t shape;
+        shape.name = shapeName;
+        size_t count = triangle - shapeStart;
+        if (count == triangleCount) {
+            shape.mesh.indices = std::move(corners);
+        } else {
+            shape.mesh.indices.assign(corners.begin() + shapeStart * 3, corners.begin() + triangle * 3);
+        }
+        shape.mesh.num_face_vertices.assign(count, 3);
+        shape.mesh.smoothing_group_ids.assign(count, 0);
+        shapes.push_back(std::move(shape));
+        shapeStart = triangle;
+    };
+    std::vector<ObjEvent> events;
+    for (size_t i = 0; i < chunkCount; ++i) {
+        for (ObjEvent& event : chunks[i].events) {
+            event.triangle += cornerBase[i] / 3;
+            events.push_back(std::move(event));
+        }
+    }
+    for (const ObjEvent& event : events) {
+        switch (event.kind) {
+        case ObjEvent::Group:
+            closeShape(event.triangle);
+            shapeName = event.name;
+            break;
+        case ObjEvent::Material: {
+            std::fill(materialIds.begin() + materialStart, materialIds.begin() + event.triangle, material);
+            materialStart = event.triangle;
+            auto found = materialMap.find(event.name);
+            if (found == materialMap.end()) {
+                warning += "material [ '" + event.name + "' ] not found in .mtl\n";
+                material = -1;
+            } else {
+                material = found->second;
+            }
+            break;
+        }
+        case ObjEvent::MaterialLibrary:
+            loadMaterialLibraries(event.name, materialDirectory, materialMap, materials, warning);
+            break;
+        }
+    }
+    std::fill(materialIds.begin() + materialStart, materialIds.end(), material);
+    closeShape(triangleCount);
+
+    size_t shapeTriangle = 0;
+    for (tinyobj::shape_t& shape : shapes) {
+        size_t count = shape.mesh.num_face_vertices.size();
+        shape.mesh.material_ids.assign(materialIds.begin() + shapeTriangle, materialIds.begin() + shapeTriangle + count);
+        shapeTriangle += count;
+    }
+    return true;
+}
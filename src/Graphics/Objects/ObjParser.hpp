@@ -0,0 +1,28 @@
+#ifndef OBJPARSER_HPP
+#define OBJPARSER_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <tiny_obj_loader.h>
+
+// multithreaded Wavefront OBJ parser that reads straight from a memory mapped file and
+// fills the same tinyobj structures tinyobj::LoadObj does, so mesh building is shared
+//
+// the text is cut into line aligned chunks that are parsed on the ThreadPool, each into
+// its own arrays, then merged in file order (relative indices are resolved at the merge)
+// supports v (with optional rgb colors), vt, vn, f (polygons are fan triangulated),
+// o / g (a new shape each, like tinyobj), usemtl and mtllib (read with tinyobj::LoadMtl
+// from materialDirectory), other statements are skipped
+// floats are parsed with a from_chars style routine, exact for up to 15 significant
+// digits and at most one float ulp off strtof past that
+
+// parses size bytes of OBJ text, false with error set when the text is malformed
+bool parseObj(const char* text, size_t size, const std::string& materialDirectory, tinyobj::attrib_t& attrib,
+              std::vector<tinyobj::shape_t>& shapes, std::vector<tinyobj::material_t>& materials,
+              std::string& warning, std::string& error);
+
+// fast path for one float, reads [+-]digits[.digits][(e|E)[+-]digits] from p and moves p past it
+bool parseObjFloat(const char*& p, const char* end, float& value);
+
+#endif // OBJPARSER_HPP
@@ -13,4 +13,35 @@ glm::mat4 createPerspectiveProjection(float fovY, float aspect, float nearPlane,
     return proj;
 }
 
+Frustum extractFrustum(const glm::mat4& viewProjection)
+{
+    // Gribb / Hartmann, rows of the column major matrix combined with the w row
+    glm::vec4 rows[4];
+    for (int row = 0; row < 4; ++row) {
+        rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row], viewProjection[2][row], viewProjection[3][row]);
+    }
+    Frustum frustum;
+    frustum.planes[0] = rows[3] + rows[0];
+    frustum.planes[1] = rows[3] - rows[0];
+    frustum.planes[2] = rows[3] + rows[1];
+    frustum.planes[3] = rows[3] - rows[1];
+    frustum.planes[4] = rows[3] + rows[2];
+    frustum.planes[5] = rows[3] - rows[2];
+    for (glm::vec4& plane : frustum.planes) {
+        float length = glm::length(glm::vec3(plane.x, plane.y, plane.z));
+        if (length > 0.0f) {
+            plane = plane * (1.0f / length);
+        }
+    }
+    return frustum;
+}
 
+bool sphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius)
+{
+    for (const glm::vec4& plane : frustum.planes) {
+        if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
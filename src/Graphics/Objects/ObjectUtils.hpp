@@ -6,6 +6,17 @@
 
 glm::mat4 createPerspectiveProjection(float fovY, float aspect, float nearPlane, float farPlane);
 
+// six inward facing planes (xyz normal, w distance) in the space the matrix was built from,
+// pass projection * view for world space or projection * view * model for object space
+// near is taken from the -w < z clip range, which also holds for 0 < z clip spaces
+struct Frustum {
+    glm::vec4 planes[6];
+};
+
+Frustum extractFrustum(const glm::mat4& viewProjection);
+// false only when the sphere is entirely outside one plane
+bool sphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius);
+
 
 
 #endif // OBJECTUTILS_HPP
\ No newline at end of file
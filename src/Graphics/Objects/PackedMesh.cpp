@@ -0,0 +1,264 @@
+#include "PackedMesh.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#include "Model.hpp"
+
+namespace
+{
+    template <typename T>
+    void storeAt(uint8_t* vertex, uint32_t offset, const T& value) {
+        std::memcpy(vertex + offset, &value, sizeof(T));
+    }
+
+    template <typename T>
+    T loadAt(const uint8_t* vertex, uint32_t offset) {
+        T value;
+        std::memcpy(&value, vertex + offset, sizeof(T));
+        return value;
+    }
+
+    uint8_t unorm8(float value) {
+        return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+    }
+
+    int8_t snorm8(float value) {
+        return static_cast<int8_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 127.0f));
+    }
+
+    uint16_t quantize16(float value, float minimum, float extent) {
+        if (extent <= 0.0f) {
+            return 0;
+        }
+        return static_cast<uint16_t>(std::lround(std::clamp((value - minimum) / extent, 0.0f, 1.0f) * 65535.0f));
+    }
+}
+
+uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    uint32_t exponentBits = (bits >> 23) & 0xffu;
+    uint32_t mantissa = bits & 0x7fffffu;
+
+    if (exponentBits == 0xffu) {
+        // inf stays inf, nan stays a quiet nan
+        return static_cast<uint16_t>(sign | 0x7c00u | (mantissa != 0 ? 0x200u : 0u));
+    }
+    int exponent = static_cast<int>(exponentBits) - 127 + 15;
+    if (exponent >= 31) {
+        return static_cast<uint16_t>(sign | 0x7c00u);
+    }
+    if (exponent <= 0) {
+        // subnormal half, or zero when it is too small even for that
+        if (exponent < -10) {
+            return static_cast<uint16_t>(sign);
+        }
+        mantissa |= 0x800000u;
+        uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1u))) {
+            ++half;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+    // round to nearest even, a carry out of the mantissa correctly bumps the exponent
+    uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1fffu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) {
+        ++half;
+    }
+    return static_cast<uint16_t>(sign | half);
+}
+
+float halfToFloat(uint16_t value) {
+    uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+    uint32_t exponent = (value >> 10) & 0x1fu;
+    uint32_t mantissa = value & 0x3ffu;
+    uint32_t bits;
+    if (exponent == 0x1fu) {
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    } else if (exponent != 0) {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    } else if (mantissa != 0) {
+        // subnormal half, normalize into a float
+        exponent = 127 - 15 + 1;
+        while ((mantissa & 0x400u) == 0) {
+            mantissa <<= 1;
+            --exponent;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+    } else {
+        bits = sign;
+    }
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+void octahedralEncode(const glm::vec3& normal, int16_t encoded[2]) {
+    float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+    float x = 0.0f, y = 0.0f;
+    if (length > 0.0f) {
+        x = normal.x / length;
+        y = normal.y / length;
+        if (normal.z < 0.0f) {
+            // fold the lower hemisphere over the diagonals
+            float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = foldedX;
+            y = foldedY;
+        }
+    }
+    encoded[0] = static_cast<int16_t>(std::lround(std::clamp(x, -1.0f, 1.0f) * 32767.0f));
+    encoded[1] = static_cast<int16_t>(std::lround(std::clamp(y, -1.0f, 1.0f) * 32767.0f));
+}
+
+glm::vec3 octahedralDecode(const int16_t encoded[2]) {
+    float x = std::max(encoded[0] / 32767.0f, -1.0f);
+    float y = std::max(encoded[1] / 32767.0f, -1.0f);
+    float z = 1.0f - std::fabs(x) - std::fabs(y);
+    if (z < 0.0f) {
+        float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    glm::vec3 normal(x, y, z);
+    return normal / glm::length(normal);
+}
+
+PackedMesh packMesh(const Mesh& mesh, bool quantizePositions, bool splitPositions) {
+    PackedMesh packed;
+    packed.vertexCount = mesh.vertices.size();
+
+    bool hasColor = false;
+    glm::vec3 minimum(0.0f), maximum(0.0f);
+    if (!mesh.vertices.empty()) {
+        minimum = maximum = mesh.vertices[0].position;
+    }
+    for (const Vertex& vertex : mesh.vertices) {
+        minimum = glm::min(minimum, vertex.position);
+        maximum = glm::max(maximum, vertex.position);
+        hasColor = hasColor || vertex.color != glm::vec3(1.0f, 1.0f, 1.0f);
+    }
+    glm::vec3 extent = maximum - minimum;
+    bool finiteBounds = std::isfinite(extent.x) && std::isfinite(extent.y) && std::isfinite(extent.z);
+
+    uint32_t positionSize = 3 * sizeof(float);
+    if (quantizePositions && finiteBounds) {
+        packed.attributes |= kPackedQuantizedPosition;
+        packed.positionOffset = minimum;
+        packed.positionScale = extent / 65535.0f;
+        positionSize = 4 * sizeof(uint16_t);
+    }
+    if (splitPositions) {
+        packed.attributes |= kPackedSplitPositions;
+        packed.positionStride = positionSize;
+        packed.normalOffset = 0;
+    } else {
+        packed.normalOffset = positionSize;
+    }
+    packed.texCoordOffset = packed.normalOffset + 2 * sizeof(int16_t);
+    packed.stride = packed.texCoordOffset + 2 * sizeof(uint16_t);
+    if (hasColor) {
+        packed.attributes |= kPackedColor;
+        packed.colorOffset = packed.stride;
+        packed.stride += 4;
+    }
+    bool hasTangents = !mesh.tangents.empty() && mesh.tangents.size() == mesh.vertices.size();
+    if (hasTangents) {
+        packed.attributes |= kPackedTangent;
+        packed.tangentOffset = packed.stride;
+        packed.stride += 4;
+    }
+
+    packed.vertices.resize(packed.vertexCount * packed.stride);
+    packed.positions.resize(packed.vertexCount * packed.positionStride);
+    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+        const Vertex& vertex = mesh.vertices[i];
+        uint8_t* out = packed.vertices.data() + i * packed.stride;
+        uint8_t* outPosition = splitPositions ? packed.positions.data() + i * packed.positionStride : out;
+
+        if (packed.attributes & kPackedQuantizedPosition) {
+            uint16_t position[4] = {
+                quantize16(vertex.position.x, minimum.x, extent.x),
+                quantize16(vertex.position.y, minimum.y, extent.y),
+                quantize16(vertex.position.z, minimum.z, extent.z),
+                0
+            };
+            storeAt(outPosition, 0, position);
+        } else {
+            float position[3] = {vertex.position.x, vertex.position.y, vertex.position.z};
+            storeAt(outPosition, 0, position);
+        }
+
+        int16_t normal[2];
+        octahedralEncode(vertex.normal, normal);
+        storeAt(out, packed.normalOffset, normal);
+
+        uint16_t texCoord[2] = {floatToHalf(vertex.texCoord.x), floatToHalf(vertex.texCoord.y)};
+        storeAt(out, packed.texCoordOffset, texCoord);
+
+        if (packed.attributes & kPackedColor) {
+            uint8_t color[4] = {unorm8(vertex.color.x), unorm8(vertex.color.y), unorm8(vertex.color.z), 255};
+            storeAt(out, packed.colorOffset, color);
+        }
+
+        if (hasTangents) {
+            const glm::vec4& tangent = mesh.tangents[i];
+            int8_t packedTangent[4] = {snorm8(tangent.x), snorm8(tangent.y), snorm8(tangent.z), snorm8(tangent.w)};
+            storeAt(out, packed.tangentOffset, packedTangent);
+        }
+    }
+
+    if (packed.vertexCount < 65536) {
+        packed.indices16.assign(mesh.indices.begin(), mesh.indices.end());
+    } else {
+        packed.indices32 = mesh.indices;
+    }
+    return packed;
+}
+
+Vertex unpackVertex(const PackedMesh& packed, size_t index) {
+    Vertex vertex{};
+    const uint8_t* in = packed.vertices.data() + index * packed.stride;
+    const uint8_t* inPosition = (packed.attributes & kPackedSplitPositions) ? packed.positions.data() + index * packed.positionStride : in;
+
+    if (packed.attributes & kPackedQuantizedPosition) {
+        auto position = loadAt<std::array<uint16_t, 4>>(inPosition, 0);
+        vertex.position = packed.positionOffset + glm::vec3(position[0], position[1], position[2]) * packed.positionScale;
+    } else {
+        auto position = loadAt<std::array<float, 3>>(inPosition, 0);
+        vertex.position = glm::vec3(position[0], position[1], position[2]);
+    }
+
+    auto normal = loadAt<std::array<int16_t, 2>>(in, packed.normalOffset);
+    vertex.normal = octahedralDecode(normal.data());
+
+    auto texCoord = loadAt<std::array<uint16_t, 2>>(in, packed.texCoordOffset);
+    vertex.texCoord = glm::vec2(halfToFloat(texCoord[0]), halfToFloat(texCoord[1]));
+
+    if (packed.attributes & kPackedColor) {
+        auto color = loadAt<std::array<uint8_t, 4>>(in, packed.colorOffset);
+        vertex.color = glm::vec3(color[0], color[1], color[2]) / 255.0f;
+    } else {
+        vertex.color = glm::vec3(1.0f, 1.0f, 1.0f);
+    }
+    return vertex;
+}
+
+glm::vec4 unpackTangent(const PackedMesh& packed, size_t index) {
+    if (!(packed.attributes & kPackedTangent)) {
+        return glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
+    }
+    auto tangent = loadAt<std::array<int8_t, 4>>(packed.vertices.data() + index * packed.stride, packed.tangentOffset);
+    glm::vec3 direction = glm::vec3(tangent[0], tangent[1], tangent[2]) / 127.0f;
+    float length = glm::length(direction);
+    return glm::vec4(length > 0.0f ? direction / length : glm::vec3(1.0f, 0.0f, 0.0f), tangent[3] < 0 ? -1.0f : 1.0f);
+}
@@ -0,0 +1,72 @@
+#ifndef PACKEDMESH_HPP
+#define PACKEDMESH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// compact GPU side copy of a Mesh, built by the loader next to the full float
+// vertices (which stay around for CPU work)
+//
+// vertex layout, every attribute 4 byte aligned:
+//   position  uint16 x4 quantized to the mesh bounds (8 bytes)   kPackedQuantizedPosition
+//             float x3 otherwise (12 bytes)
+//   normal    int16 x2 octahedral, snorm (4 bytes)
+//   texCoord  half x2 (4 bytes)
+//   color     uint8 x4 unorm, only when some vertex is not white (4 bytes)   kPackedColor
+//   tangent   int8 x4 snorm, xyz and the handedness in w, only with Mesh::tangents (4 bytes)   kPackedTangent
+// so 16 to 28 bytes against the 44 of Vertex (60 with its tangent)
+// with kPackedSplitPositions the position is not interleaved, it lives alone in
+// positions (positionStride bytes a vertex) and vertices holds the other attributes
+// so a depth only pass binds 8 bytes a vertex
+// quantized positions decode as positionOffset + q * positionScale, the error is at most
+// half a step of the bounds / 65535, half floats keep 11 bits so uvs in [0, 1] are exact
+// to about 1/4096
+
+struct Mesh;
+struct Vertex;
+
+inline constexpr uint32_t kPackedQuantizedPosition = 1u << 0;
+inline constexpr uint32_t kPackedColor = 1u << 1;
+inline constexpr uint32_t kPackedSplitPositions = 1u << 2;
+inline constexpr uint32_t kPackedTangent = 1u << 3;
+
+struct PackedMesh {
+    uint32_t attributes = 0;  // kPacked* bits
+    uint32_t stride = 0;
+    uint32_t positionStride = 0;  // with kPackedSplitPositions, the stride of positions
+    uint32_t normalOffset = 0;
+    uint32_t texCoordOffset = 0;
+    uint32_t colorOffset = 0;
+    uint32_t tangentOffset = 0;
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec3 positionScale = glm::vec3(1.0f);
+
+    size_t vertexCount = 0;
+    std::vector<uint8_t> vertices;
+    std::vector<uint8_t> positions;  // only with kPackedSplitPositions
+    // exactly one of these is filled, 16 bit whenever the mesh has fewer than 65536 vertices
+    std::vector<uint16_t> indices16;
+    std::vector<uint32_t> indices32;
+
+    bool uses16BitIndices() const { return !indices16.empty(); }
+    size_t indexCount() const { return indices16.empty() ? indices32.size() : indices16.size(); }
+    size_t byteSize() const { return vertices.size() + positions.size() + indices16.size() * sizeof(uint16_t) + indices32.size() * sizeof(uint32_t); }
+};
+
+// picks the layout for mesh, quantizePositions allows the 16 bit position encoding,
+// splitPositions moves positions into their own stream
+PackedMesh packMesh(const Mesh& mesh, bool quantizePositions, bool splitPositions = false);
+// decodes one packed vertex back to floats, missing colors come back white
+Vertex unpackVertex(const PackedMesh& packed, size_t index);
+// decodes one packed tangent, +x with w 1 when the mesh has none
+glm::vec4 unpackTangent(const PackedMesh& packed, size_t index);
+
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t value);
+// unit vector to two snorm16 values on the octahedron, zero vectors map to +z
+void octahedralEncode(const glm::vec3& normal, int16_t encoded[2]);
+glm::vec3 octahedralDecode(const int16_t encoded[2]);
+
+#endif // PACKEDMESH_HPP
@@ -0,0 +1,534 @@
+#include "ShaderReflection.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace
+{
+    constexpr uint32_t kSpirvMagic = 0x07230203u;
+    constexpr size_t kHeaderWords = 5;
+    constexpr uint32_t kNone = UINT32_MAX;
+
+    // the subset of the SPIR-V grammar reflection needs
+    enum Op : uint32_t {
+        OpName = 5,
+        OpEntryPoint = 15,
+        OpExecutionMode = 16,
+        OpTypeBool = 20,
+        OpTypeInt = 21,
+        OpTypeFloat = 22,
+        OpTypeVector = 23,
+        OpTypeMatrix = 24,
+        OpTypeImage = 25,
+        OpTypeSampler = 26,
+        OpTypeSampledImage = 27,
+        OpTypeArray = 28,
+        OpTypeRuntimeArray = 29,
+        OpTypeStruct = 30,
+        OpTypePointer = 32,
+        OpConstant = 43,
+        OpSpecConstantTrue = 48,
+        OpSpecConstantFalse = 49,
+        OpSpecConstant = 50,
+        OpVariable = 59,
+        OpDecorate = 71,
+        OpMemberDecorate = 72,
+        OpTypeAccelerationStructureKHR = 5341
+    };
+
+    enum Decoration : uint32_t {
+        DecorationSpecId = 1,
+        DecorationBlock = 2,
+        DecorationBufferBlock = 3,
+        DecorationArrayStride = 6,
+        DecorationMatrixStride = 7,
+        DecorationBuiltIn = 11,
+        DecorationLocation = 30,
+        DecorationBinding = 33,
+        DecorationDescriptorSet = 34,
+        DecorationOffset = 35
+    };
+
+    enum StorageClass : uint32_t {
+        StorageUniformConstant = 0,
+        StorageInput = 1,
+        StorageUniform = 2,
+        StoragePushConstant = 9,
+        StorageStorageBuffer = 12
+    };
+
+    enum Dim : uint32_t {
+        DimBuffer = 5,
+        DimSubpassData = 6
+    };
+
+    enum ExecutionModel : uint32_t {
+        ModelVertex = 0,
+        ModelGeometry = 3,
+        ModelFragment = 4,
+        ModelGLCompute = 5
+    };
+
+    constexpr uint32_t kExecutionModeLocalSize = 17;
+
+    // one id of the module, operands keep the meaning of the op that declared it:
+    // int / float: width, signedness; vector / matrix: component or column type, count;
+    // image: sampled type, dim, sampled; array: element, length id; pointer: storage, pointee;
+    // spec constant: result type
+    struct Id {
+        uint32_t op = 0;
+        uint32_t operands[3] = {0, 0, 0};
+        uint32_t constant = 0;
+        std::vector<uint32_t> members;
+        std::string name;
+
+        uint32_t set = kNone;
+        uint32_t binding = kNone;
+        uint32_t location = kNone;
+        uint32_t arrayStride = 0;
+        uint32_t specId = kNone;
+        bool block = false;
+        bool bufferBlock = false;
+        bool builtIn = false;
+    };
+
+    struct Member {
+        uint32_t offset = 0;
+        uint32_t matrixStride = 0;
+        bool builtIn = false;
+    };
+
+    struct Module {
+        std::vector<Id> ids;
+        std::unordered_map<uint64_t, Member> members;
+
+        bool has(uint32_t id) const { return id < ids.size(); }
+        Member member(uint32_t type, uint32_t index) const {
+            auto found = members.find((static_cast<uint64_t>(type) << 32) | index);
+            return found != members.end() ? found->second : Member{};
+        }
+
+        // bytes of type in a block, enough to size push constants
+        uint32_t sizeOf(uint32_t type, uint32_t matrixStride = 0, int depth = 0) const {
+            if (!has(type) || depth > 16) {
+                return 0;
+            }
+            const Id& id = ids[type];
+            switch (id.op) {
+            case OpTypeBool:
+                return 4;
+            case OpTypeInt:
+            case OpTypeFloat:
+                return id.operands[0] / 8;
+            case OpTypeVector:
+                return id.operands[1] * sizeOf(id.operands[0], 0, depth + 1);
+            case OpTypeMatrix:
+                return id.operands[1] * (matrixStride != 0 ? matrixStride : sizeOf(id.operands[0], 0, depth + 1));
+            case OpTypeArray: {
+                uint32_t length = has(id.operands[1]) ? ids[id.operands[1]].constant : 0;
+                uint32_t stride = id.arrayStride != 0 ? id.arrayStride : sizeOf(id.operands[0], matrixStride, depth + 1);
+                return length * stride;
+            }
+            case OpTypeStruct: {
+                uint32_t size = 0;
+                for (uint32_t m = 0; m < id.members.size(); ++m) {
+                    Member info = member(type, m);
+                    size = std::max(size, info.offset + sizeOf(id.members[m], info.matrixStride, depth + 1));
+                }
+                return size;
+            }
+            default:
+                return 0;
+            }
+        }
+
+        bool isBuiltInBlock(uint32_t type) const {
+            if (!has(type) || ids[type].op != OpTypeStruct) {
+                return false;
+            }
+            for (uint32_t m = 0; m < ids[type].members.size(); ++m) {
+                if (member(type, m).builtIn) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    std::string readString(const uint32_t* words, size_t count) {
+        std::string text;
+        for (size_t i = 0; i < count; ++i) {
+            for (int byte = 0; byte < 4; ++byte) {
+                char c = static_cast<char>((words[i] >> (byte * 8)) & 0xFF);
+                if (c == '\0') {
+                    return text;
+                }
+                text.push_back(c);
+            }
+        }
+        return text;
+    }
+
+    ShaderStage stageOf(uint32_t model) {
+        switch (model) {
+        case ModelVertex:
+            return ShaderStage::Vertex;
+        case ModelGeometry:
+            return ShaderStage::Geometry;
+        case ModelFragment:
+            return ShaderStage::Fragment;
+        case ModelGLCompute:
+            return ShaderStage::Compute;
+        default:
+            return ShaderStage::Count;
+        }
+    }
+
+    // resource kind of a UniformConstant variable's type, false for types that take no descriptor
+    bool classifyOpaque(const Module& module, uint32_t type, ShaderResourceType& resource) {
+        const Id& id = module.ids[type];
+        switch (id.op) {
+        case OpTypeSampler:
+            resource = ShaderResourceType::Sampler;
+            return true;
+        case OpTypeSampledImage:
+            resource = ShaderResourceType::CombinedImageSampler;
+            return true;
+        case OpTypeImage:
+            if (id.operands[1] == DimBuffer) {
+                resource = id.operands[2] == 2 ? ShaderResourceType::StorageTexelBuffer : ShaderResourceType::UniformTexelBuffer;
+            } else if (id.operands[1] == DimSubpassData) {
+                resource = ShaderResourceType::InputAttachment;
+            } else {
+                resource = id.operands[2] == 2 ? ShaderResourceType::StorageImage : ShaderResourceType::SampledImage;
+            }
+            return true;
+        case OpTypeAccelerationStructureKHR:
+            resource = ShaderResourceType::AccelerationStructure;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    void addVertexInput(const Module& module, uint32_t location, uint32_t type, std::vector<ShaderVertexInput>& inputs) {
+        const Id& id = module.ids[type];
+        uint32_t columns = 1;
+        uint32_t vectorType = type;
+        if (id.op == OpTypeMatrix) {
+            columns = id.operands[1];
+            vectorType = id.operands[0];
+        }
+        if (!module.has(vectorType)) {
+            return;
+        }
+        uint32_t components = 1;
+        uint32_t scalarType = vectorType;
+        if (module.ids[vectorType].op == OpTypeVector) {
+            components = module.ids[vectorType].operands[1];
+            scalarType = module.ids[vectorType].operands[0];
+        }
+        ShaderScalarType scalar = ShaderScalarType::Other;
+        if (module.has(scalarType)) {
+            const Id& scalarId = module.ids[scalarType];
+            if (scalarId.op == OpTypeFloat) {
+                scalar = ShaderScalarType::Float;
+            } else if (scalarId.op == OpTypeInt) {
+                scalar = scalarId.operands[1] ? ShaderScalarType::Int : ShaderScalarType::Uint;
+            }
+        }
+        for (uint32_t column = 0; column < columns; ++column) {
+            inputs.push_back(ShaderVertexInput{location + column, scalar, components});
+        }
+    }
+}
+
+const char* shaderStageName(ShaderStage stage) {
+    switch (stage) {
+    case ShaderStage::Vertex:
+        return "vertex";
+    case ShaderStage::Fragment:
+        return "fragment";
+    case ShaderStage::Compute:
+        return "compute";
+    case ShaderStage::Geometry:
+        return "geometry";
+    default:
+        return "unknown";
+    }
+}
+
+bool reflectSpirv(const uint32_t* words, size_t wordCount, ShaderReflection& reflection) {
+    reflection = ShaderReflection();
+    if (words == nullptr || wordCount < kHeaderWords || words[0] != kSpirvMagic) {
+        return false;
+    }
+    uint32_t bound = words[3];
+    // ids are below bound, which no valid module sets far above its own word count
+    if (bound == 0 || bound > wordCount * 4) {
+        return false;
+    }
+
+    Module module;
+    module.ids.resize(bound);
+    std::vector<uint32_t> variables;
+    std::vector<uint32_t> specConstants;
+    uint32_t entryId = kNone;
+
+    for (size_t offset = kHeaderWords; offset < wordCount;) {
+        uint32_t opcode = words[offset] & 0xFFFF;
+        uint32_t count = words[offset] >> 16;
+        if (count == 0 || offset + count > wordCount) {
+            return false;
+        }
+        const uint32_t* operands = words + offset + 1;
+        uint32_t operandCount = count - 1;
+        offset += count;
+
+        // every declaration below names its result id in operands[0] (operands[1] for
+        // OpConstant and OpVariable, which lead with the result type)
+        auto id = [&](uint32_t index) -> Id* {
+            return index < operandCount && module.has(operands[index]) ? &module.ids[operands[index]] : nullptr;
+        };
+        auto declare = [&](uint32_t index) -> Id* {
+            Id* declared = id(index);
+            if (declared != nullptr) {
+                declared->op = opcode;
+                for (uint32_t i = 0; i < 3 && index + 1 + i < operandCount; ++i) {
+                    declared->operands[i] = operands[index + 1 + i];
+                }
+            }
+            return declared;
+        };
+
+        switch (opcode) {
+        case OpName:
+            if (Id* named = id(0)) {
+                named->name = readString(operands + 1, operandCount - 1);
+            }
+            break;
+        case OpEntryPoint:
+            if (entryId == kNone && operandCount >= 3) {
+                entryId = operands[1];
+                reflection.stage = stageOf(operands[0]);
+                reflection.entryPoint = readString(operands + 2, operandCount - 2);
+            }
+            break;
+        case OpExecutionMode:
+            if (operandCount >= 5 && operands[0] == entryId && operands[1] == kExecutionModeLocalSize) {
+                reflection.localSize[0] = operands[2];
+                reflection.localSize[1] = operands[3];
+                reflection.localSize[2] = operands[4];
+            }
+            break;
+        case OpTypeBool:
+        case OpTypeInt:
+        case OpTypeFloat:
+        case OpTypeVector:
+        case OpTypeMatrix:
+        case OpTypeSampler:
+        case OpTypeSampledImage:
+        case OpTypeArray:
+        case OpTypeRuntimeArray:
+        case OpTypePointer:
+        case OpTypeAccelerationStructureKHR:
+            declare(0);
+            break;
+        case OpTypeImage:
+            if (Id* image = declare(0)) {
+                // sampled type, dim, then depth / arrayed / ms, sampled
+                image->operands[2] = operandCount > 6 ? operands[6] : 0;
+            }
+            break;
+        case OpTypeStruct:
+            if (Id* structure = declare(0)) {
+                structure->members.assign(operands + 1, operands + operandCount);
+            }
+            break;
+        case OpConstant:
+            if (Id* constant = declare(1)) {
+                constant->constant = operandCount > 2 ? operands[2] : 0;
+            }
+            break;
+        case OpSpecConstantTrue:
+        case OpSpecConstantFalse:
+        case OpSpecConstant:
+            if (Id* constant = id(1)) {
+                constant->op = opcode;
+                constant->operands[0] = operands[0];
+                if (opcode == OpSpecConstant) {
+                    constant->constant = operandCount > 2 ? operands[2] : 0;
+                } else {
+                    constant->constant = opcode == OpSpecConstantTrue ? 1 : 0;
+                }
+                specConstants.push_back(operands[1]);
+            }
+            break;
+        case OpVariable:
+            if (Id* variable = declare(1)) {
+                // result type is the pointer, storage class follows the result id
+                variable->operands[0] = operands[0];
+                variable->operands[1] = operandCount > 2 ? operands[2] : 0;
+                variables.push_back(operands[1]);
+            }
+            break;
+        case OpDecorate:
+            if (Id* target = id(0); target != nullptr && operandCount >= 2) {
+                uint32_t value = operandCount > 2 ? operands[2] : 0;
+                switch (operands[1]) {
+                case DecorationSpecId:
+                    target->specId = value;
+                    break;
+                case DecorationBlock:
+                    target->block = true;
+                    break;
+                case DecorationBufferBlock:
+                    target->bufferBlock = true;
+                    break;
+                case DecorationArrayStride:
+                    target->arrayStride = value;
+                    break;
+                case DecorationBuiltIn:
+                    target->builtIn = true;
+                    break;
+                case DecorationLocation:
+                    target->location = value;
+                    break;
+                case DecorationBinding:
+                    target->binding = value;
+                    break;
+                case DecorationDescriptorSet:
+                    target->set = value;
+                    break;
+                default:
+                    break;
+                }
+            }
+            break;
+        case OpMemberDecorate:
+            if (operandCount >= 3) {
+                Member& member = module.members[(static_cast<uint64_t>(operands[0]) << 32) | operands[1]];
+                uint32_t value = operandCount > 3 ? operands[3] : 0;
+                if (operands[2] == DecorationOffset) {
+                    member.offset = value;
+                } else if (operands[2] == DecorationMatrixStride) {
+                    member.matrixStride = value;
+                } else if (operands[2] == DecorationBuiltIn) {
+                    member.builtIn = true;
+                }
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    if (entryId == kNone) {
+        return false;
+    }
+
+    ShaderStageMask stageBit = reflection.stage != ShaderStage::Count ? shaderStageBit(reflection.stage) : 0;
+    for (uint32_t variableId : variables) {
+        const Id& variable = module.ids[variableId];
+        uint32_t pointerType = variable.operands[0];
+        uint32_t storage = variable.operands[1];
+        if (!module.has(pointerType) || module.ids[pointerType].op != OpTypePointer) {
+            continue;
+        }
+        uint32_t type = module.ids[pointerType].operands[1];
+        if (!module.has(type)) {
+            continue;
+        }
+
+        if (storage == StoragePushConstant) {
+            reflection.pushConstantSize = std::max(reflection.pushConstantSize, module.sizeOf(type));
+            continue;
+        }
+        if (storage == StorageInput) {
+            if (reflection.stage == ShaderStage::Vertex && !variable.builtIn && variable.location != kNone && !module.isBuiltInBlock(type)) {
+                addVertexInput(module, variable.location, type, reflection.vertexInputs);
+            }
+            continue;
+        }
+        if (storage != StorageUniformConstant && storage != StorageUniform && storage != StorageStorageBuffer) {
+            continue;
+        }
+        if (variable.binding == kNone) {
+            continue;
+        }
+
+        // arrays of resources take one binding with count descriptors
+        uint32_t count = 1;
+        while (module.ids[type].op == OpTypeArray || module.ids[type].op == OpTypeRuntimeArray) {
+            const Id& array = module.ids[type];
+            if (array.op == OpTypeRuntimeArray) {
+                count = 0;
+            } else if (module.has(array.operands[1])) {
+                count *= module.ids[array.operands[1]].constant;
+            }
+            type = array.operands[0];
+            if (!module.has(type)) {
+                break;
+            }
+        }
+        if (!module.has(type)) {
+            continue;
+        }
+
+        ShaderResourceType resource;
+        if (storage == StorageUniformConstant) {
+            if (!classifyOpaque(module, type, resource)) {
+                continue;
+            }
+        } else if (storage == StorageStorageBuffer || module.ids[type].bufferBlock) {
+            resource = ShaderResourceType::StorageBuffer;
+        } else {
+            resource = ShaderResourceType::UniformBuffer;
+        }
+        uint32_t set = variable.set != kNone ? variable.set : 0;
+        reflection.bindings.push_back(ShaderResourceBinding{set, variable.binding, resource, count, stageBit});
+    }
+
+    for (uint32_t constantId : specConstants) {
+        const Id& constant = module.ids[constantId];
+        if (constant.specId == kNone || !module.has(constant.operands[0])) {
+            continue;
+        }
+        const Id& type = module.ids[constant.operands[0]];
+        bool boolean = type.op == OpTypeBool;
+        uint32_t size = boolean ? 4 : type.operands[0] / 8;
+        // 64 bit constants keep their default, only their low word is read above
+        if (size == 0 || size > 4) {
+            continue;
+        }
+        reflection.specConstants.push_back(ShaderSpecConstant{constant.specId, constant.name, boolean, size, constant.constant});
+    }
+
+    std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](const ShaderResourceBinding& a, const ShaderResourceBinding& b) {
+        return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+    });
+    std::sort(reflection.vertexInputs.begin(), reflection.vertexInputs.end(), [](const ShaderVertexInput& a, const ShaderVertexInput& b) {
+        return a.location < b.location;
+    });
+    std::sort(reflection.specConstants.begin(), reflection.specConstants.end(), [](const ShaderSpecConstant& a, const ShaderSpecConstant& b) {
+        return a.constantId < b.constantId;
+    });
+    reflection.valid = true;
+    return true;
+}
+
+bool mergeShaderBindings(std::vector<ShaderResourceBinding>& merged, const std::vector<ShaderResourceBinding>& stageBindings) {
+    for (const ShaderResourceBinding& binding : stageBindings) {
+        auto slot = std::lower_bound(merged.begin(), merged.end(), binding, [](const ShaderResourceBinding& a, const ShaderResourceBinding& b) {
+            return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+        });
+        if (slot != merged.end() && slot->set == binding.set && slot->binding == binding.binding) {
+            if (slot->type != binding.type || slot->count != binding.count) {
+                return false;
+            }
+            slot->stages |= binding.stages;
+        } else {
+            merged.insert(slot, binding);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,104 @@
+#ifndef SHADERREFLECTION_HPP
+#define SHADERREFLECTION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// what a SPIR-V module asks of its pipeline: resource bindings, push constants, vertex
+// inputs, specialization constants, read straight from the binary's decorations and types
+// ShaderBinary::reflection() parses each distinct binary once and keeps the result
+
+enum class ShaderStage : uint8_t {
+    Vertex,
+    Fragment,
+    Compute,
+    Geometry,
+    Count
+};
+
+// "vertex", "fragment", ... as used in the compiled file names (name.vertex.spv)
+const char* shaderStageName(ShaderStage stage);
+
+// bit per ShaderStage, a binding used by several stages of a material ORs them
+using ShaderStageMask = uint32_t;
+
+inline ShaderStageMask shaderStageBit(ShaderStage stage) {
+    return 1u << static_cast<uint32_t>(stage);
+}
+
+// resource kinds, map one to one onto VkDescriptorType
+enum class ShaderResourceType : uint8_t {
+    Sampler,
+    CombinedImageSampler,
+    SampledImage,
+    StorageImage,
+    UniformTexelBuffer,
+    StorageTexelBuffer,
+    UniformBuffer,
+    StorageBuffer,
+    InputAttachment,
+    AccelerationStructure
+};
+
+struct ShaderResourceBinding {
+    uint32_t set;
+    uint32_t binding;
+    ShaderResourceType type;
+    uint32_t count;  // array length, 0 for runtime sized arrays
+    ShaderStageMask stages;
+
+    bool operator==(const ShaderResourceBinding& other) const {
+        return set == other.set && binding == other.binding && type == other.type && count == other.count && stages == other.stages;
+    }
+};
+
+enum class ShaderScalarType : uint8_t {
+    Float,
+    Int,
+    Uint,
+    Other
+};
+
+struct ShaderVertexInput {
+    uint32_t location;
+    ShaderScalarType scalar;
+    uint32_t components;  // 1 - 4, a matrix input is one entry per column and location
+};
+
+// a specialization constant (OpSpecConstant*, decorated SpecId), fixed when the pipeline
+// is created instead of when the SPIR-V is compiled
+struct ShaderSpecConstant {
+    uint32_t constantId;
+    std::string name;  // OpName, empty when the compiler stripped it
+    bool boolean;      // bool constants take a VkBool32
+    uint32_t size;     // bytes of the value
+    uint32_t defaultValue;
+};
+
+struct ShaderReflection {
+    bool valid = false;
+    ShaderStage stage = ShaderStage::Count;
+    std::string entryPoint;
+    // sorted by set then binding
+    std::vector<ShaderResourceBinding> bindings;
+    // bytes of the push constant block, 0 without one
+    uint32_t pushConstantSize = 0;
+    // vertex stage only, sorted by location
+    std::vector<ShaderVertexInput> vertexInputs;
+    // compute stage only
+    uint32_t localSize[3] = {1, 1, 1};
+    // sorted by constant id
+    std::vector<ShaderSpecConstant> specConstants;
+};
+
+// parses one SPIR-V module, false (and reflection.valid unset) when it is malformed
+// the first entry point is reflected, slangc writes one per file
+bool reflectSpirv(const uint32_t* words, size_t wordCount, ShaderReflection& reflection);
+
+// merges the bindings of one stage into those of a whole material (stages ORed for shared
+// slots), false when two stages disagree on the type or size of a slot
+bool mergeShaderBindings(std::vector<ShaderResourceBinding>& merged, const std::vector<ShaderResourceBinding>& stageBindings);
+
+#endif // SHADERREFLECTION_HPP
@@ -0,0 +1,109 @@
+#include "ShaderRegistry.hpp"
+
+#include <cstring>
+#include <system_error>
+
+#include "Utils/Hash.hpp"
+#include "Utils/Utils.hpp"
+
+namespace
+{
+    constexpr uint32_t kSpirvMagic = 0x07230203u;
+    // magic, version, generator, bound, schema
+    constexpr size_t kSpirvHeaderBytes = 20;
+
+    bool sameContents(const ShaderBinary& binary, const MappedFile& file) {
+        return binary.size() == file.size() && std::memcmp(binary.bytes(), file.data(), file.size()) == 0;
+    }
+}
+
+const ShaderReflection& ShaderBinary::reflection() const {
+    std::call_once(reflected, [this]() {
+        if (!reflectSpirv(code(), size() / 4, reflectionData)) {
+            logMessage(2, "Failed to reflect shader: " + path(), {"Graphics", "Material", "Slang"});
+        }
+    });
+    return reflectionData;
+}
+
+ShaderRegistry& ShaderRegistry::shared() {
+    static ShaderRegistry registry;
+    return registry;
+}
+
+ShaderHandle ShaderRegistry::load(const std::string& path) {
+    std::string key = std::filesystem::path(path).lexically_normal().generic_string();
+
+    std::error_code error;
+    std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(key, error);
+    uintmax_t fileSize = error ? 0 : std::filesystem::file_size(key, error);
+    if (error) {
+        logMessage(2, "Failed to open shader file: " + path, {"Graphics", "Material", "Slang"});
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = byPath.find(key);
+        if (found != byPath.end() && found->second.writeTime == writeTime && found->second.size == fileSize) {
+            if (ShaderHandle binary = found->second.binary.lock()) {
+                return binary;
+            }
+        }
+    }
+
+    // map and hash outside the lock, other threads keep loading meanwhile
+    MappedFile file;
+    if (!file.openRead(key)) {
+        logMessage(2, "Failed to map shader file (missing or empty): " + path, {"Graphics", "Material", "Slang"});
+        return nullptr;
+    }
+    uint32_t magic = 0;
+    if (file.size() >= kSpirvHeaderBytes) {
+        std::memcpy(&magic, file.data(), sizeof(magic));
+    }
+    if (file.size() % 4 != 0 || magic != kSpirvMagic) {
+        logMessage(2, "Shader file is not SPIR-V: " + path, {"Graphics", "Material", "Slang"});
+        return nullptr;
+    }
+    uint64_t hash = hashBytes(file.data(), file.size());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ShaderHandle binary;
+    auto found = byHash.find(hash);
+    if (found != byHash.end()) {
+        binary = found->second.lock();
+        if (binary && !sameContents(*binary, file)) {
+            // a 64 bit collision, serve this file unshared rather than the wrong shader
+            logMessage(2, "Shader content hash collision, not sharing: " + path, {"Graphics", "Material", "Slang"});
+            return std::make_shared<const ShaderBinary>(std::move(file), hash);
+        }
+    }
+    if (!binary) {
+        binary = std::make_shared<const ShaderBinary>(std::move(file), hash);
+        byHash[hash] = binary;
+        logMessage(4, logFormat("Mapped shader ", path, " (", binary->size(), " bytes)"), {"Graphics", "Material", "Slang"});
+    }
+    byPath[key] = PathEntry{binary, writeTime, fileSize};
+    return binary;
+}
+
+size_t ShaderRegistry::uniqueCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = 0;
+    for (const auto& entry : byHash) {
+        count += entry.second.expired() ? 0 : 1;
+    }
+    return count;
+}
+
+size_t ShaderRegistry::mappedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t bytes = 0;
+    for (const auto& entry : byHash) {
+        if (ShaderHandle binary = entry.second.lock()) {
+            bytes += binary->size();
+        }
+    }
+    return bytes;
+}
@@ -0,0 +1,72 @@
+#ifndef SHADERREGISTRY_HPP
+#define SHADERREGISTRY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "ShaderReflection.hpp"
+#include "Utils/MappedFile.hpp"
+
+// process wide store of compiled shader binaries
+//
+// a .spv is memory mapped on first use and handed out as a shared, read only
+// ShaderBinary; binaries are keyed by the hash of their contents, so materials that
+// point at the same shader (or at byte identical copies of it) share one mapping
+// the registry only holds weak references, a binary is unmapped once the last
+// handle to it goes away and mapped again by the next load
+
+class ShaderBinary {
+public:
+    ShaderBinary(MappedFile&& file, uint64_t hash) : file(std::move(file)), contentHash(hash) {}
+
+    // SPIR-V words, the mapping is page aligned
+    const uint32_t* code() const { return reinterpret_cast<const uint32_t*>(file.data()); }
+    const uint8_t* bytes() const { return file.data(); }
+    size_t size() const { return file.size(); }
+    uint64_t hash() const { return contentHash; }
+    // the file this binary was first mapped from
+    const std::string& path() const { return file.path(); }
+    // parsed on first use, every material sharing the binary shares the result
+    const ShaderReflection& reflection() const;
+
+private:
+    MappedFile file;
+    uint64_t contentHash;
+    mutable std::once_flag reflected;
+    mutable ShaderReflection reflectionData;
+};
+
+using ShaderHandle = std::shared_ptr<const ShaderBinary>;
+
+class ShaderRegistry {
+public:
+    static ShaderRegistry& shared();
+
+    // the binary at path, mapped and hashed only when no live handle for this path
+    // (or for identical contents) exists; null when the file is missing or not SPIR-V
+    // safe to call from several threads
+    ShaderHandle load(const std::string& path);
+
+    // binaries with at least one live handle, and the bytes they map
+    size_t uniqueCount() const;
+    size_t mappedBytes() const;
+
+private:
+    struct PathEntry {
+        std::weak_ptr<const ShaderBinary> binary;
+        // a rebuilt shader at the same path is mapped again
+        std::filesystem::file_time_type writeTime;
+        uintmax_t size = 0;
+    };
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, PathEntry> byPath;
+    std::unordered_map<uint64_t, std::weak_ptr<const ShaderBinary>> byHash;
+};
+
+#endif // SHADERREGISTRY_HPP
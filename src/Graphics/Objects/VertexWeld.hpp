@@ -0,0 +1,143 @@
+#ifndef VERTEXWELD_HPP
+#define VERTEXWELD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// flat open addressing table for welding identical vertices, works on any
+// trivially copyable vertex struct
+// vertices are hashed and compared as raw bytes, so the struct must not have
+// padding (or must be zero initialized) and floats compare bitwise:
+// -0.0 and 0.0 stay separate vertices unless the caller folds them with
+// weldZero first, NaNs with the same bits weld
+// slots only hold a 32 bit hash and an index into the output vertex array,
+// nothing is allocated per vertex and growing never rehashes vertex data
+
+// -0.0 compares equal to 0.0 and becomes +0.0, everything else passes through
+inline float weldZero(float value)
+{
+    return value == 0.0f ? 0.0f : value;
+}
+
+namespace vertexweld
+{
+    inline uint64_t rotl(uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    // xxhash64 style: four independent lanes over 8 byte words so the
+    // multiplies pipeline (and vectorize where the compiler can), then avalanche
+    template <size_t Size>
+    uint32_t hashBytes(const unsigned char *bytes)
+    {
+        constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+        constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+        constexpr uint64_t kPrime3 = 0x165667B19E3779F9ull;
+        constexpr size_t kWords = Size / 8;
+
+        uint64_t lanes[4] = {kPrime1 + kPrime2, kPrime2, 0, 0 - kPrime1};
+        for (size_t i = 0; i < kWords; ++i)
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes + i * 8, 8);
+            lanes[i & 3] = rotl(lanes[i & 3] + word * kPrime2, 31) * kPrime1;
+        }
+        uint64_t hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18) + Size;
+
+        size_t offset = kWords * 8;
+        if constexpr (Size % 8 >= 4)
+        {
+            uint32_t word;
+            std::memcpy(&word, bytes + offset, 4);
+            hash = rotl(hash ^ (word * kPrime1), 23) * kPrime2 + kPrime3;
+            offset += 4;
+        }
+        for (; offset < Size; ++offset)
+            hash = rotl(hash ^ (bytes[offset] * kPrime3), 11) * kPrime1;
+
+        hash ^= hash >> 33;
+        hash *= kPrime2;
+        hash ^= hash >> 29;
+        hash *= kPrime3;
+        hash ^= hash >> 32;
+        return static_cast<uint32_t>(hash);
+    }
+}
+
+template <typename VertexT>
+class VertexWeldTable
+{
+    static_assert(std::is_trivially_copyable_v<VertexT>, "VertexWeldTable hashes vertices as raw bytes");
+
+public:
+    // unique vertices are appended to vertices, expectedVertices sizes the table up front
+    explicit VertexWeldTable(std::vector<VertexT> &vertices, size_t expectedVertices = 0)
+        : vertices_(vertices)
+    {
+        size_t capacity = 16;
+        // stays at most half full
+        while (capacity < expectedVertices * 2)
+            capacity *= 2;
+        slots_.assign(capacity, Slot{0, kEmpty});
+        mask_ = capacity - 1;
+    }
+
+    // returns the index of vertex in the output array, appending it if it is new
+    uint32_t weld(const VertexT &vertex)
+    {
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&vertex);
+        uint32_t hash = vertexweld::hashBytes<sizeof(VertexT)>(bytes);
+        for (size_t slot = hash & mask_;; slot = (slot + 1) & mask_)
+        {
+            Slot &entry = slots_[slot];
+            if (entry.index == kEmpty)
+            {
+                uint32_t index = static_cast<uint32_t>(vertices_.size());
+                entry = Slot{hash, index};
+                vertices_.push_back(vertex);
+                if (++count_ * 2 > slots_.size())
+                    grow();
+                return index;
+            }
+            if (entry.hash == hash && std::memcmp(&vertices_[entry.index], bytes, sizeof(VertexT)) == 0)
+                return entry.index;
+        }
+    }
+
+    size_t size() const { return count_; }
+
+private:
+    struct Slot
+    {
+        uint32_t hash;
+        uint32_t index;
+    };
+    static constexpr uint32_t kEmpty = UINT32_MAX;
+
+    std::vector<VertexT> &vertices_;
+    std::vector<Slot> slots_;
+    size_t mask_ = 0;
+    size_t count_ = 0;
+
+    void grow()
+    {
+        std::vector<Slot> old(slots_.size() * 2, Slot{0, kEmpty});
+        old.swap(slots_);
+        mask_ = slots_.size() - 1;
+        for (const Slot &entry : old)
+        {
+            if (entry.index == kEmpty)
+                continue;
+            size_t slot = entry.hash & mask_;
+            while (slots_[slot].index != kEmpty)
+                slot = (slot + 1) & mask_;
+            slots_[slot] = entry;
+        }
+    }
+};
+
+#endif // VERTEXWELD_HPP
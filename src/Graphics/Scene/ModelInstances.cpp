@@ -0,0 +1,196 @@
+#include "ModelInstances.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Graphics/Objects/MeshLod.hpp"
+
+namespace
+{
+    glm::vec3 transformPoint(const glm::mat4& transform, const glm::vec3& point) {
+        glm::vec3 result;
+        for (int row = 0; row < 3; ++row) {
+            result[row] = transform[0][row] * point.x + transform[1][row] * point.y + transform[2][row] * point.z + transform[3][row];
+        }
+        return result;
+    }
+
+    float maxAxisScale(const glm::mat4& transform) {
+        float largest = 0.0f;
+        for (int column = 0; column < 3; ++column) {
+            glm::vec3 axis(transform[column][0], transform[column][1], transform[column][2]);
+            largest = std::max(largest, glm::dot(axis, axis));
+        }
+        return std::sqrt(largest);
+    }
+
+    void appendDraws(const Model& model, uint32_t meshIndex, uint32_t lod, uint32_t firstInstance, uint32_t instanceCount, std::vector<InstancedDraw>& draws) {
+        const Mesh& mesh = model.getMeshes()[meshIndex];
+        const MeshLod& level = mesh.lods[lod];
+        if (level.submeshCount == 0 && level.indexCount != 0) {
+            draws.push_back(InstancedDraw{&model, meshIndex, lod, 0, level.indexOffset, level.indexCount, firstInstance, instanceCount});
+            return;
+        }
+        for (uint32_t s = level.submeshOffset; s < level.submeshOffset + level.submeshCount; ++s) {
+            const Submesh& submesh = mesh.submeshes[s];
+            draws.push_back(InstancedDraw{&model, meshIndex, lod, submesh.material, submesh.indexOffset, submesh.indexCount, firstInstance, instanceCount});
+        }
+    }
+}
+
+InstanceTransform packInstanceTransform(const glm::mat4& transform) {
+    InstanceTransform packed;
+    for (int row = 0; row < 3; ++row) {
+        packed.rows[row] = glm::vec4(transform[0][row], transform[1][row], transform[2][row], transform[3][row]);
+    }
+    return packed;
+}
+
+ModelInstances::Instance ModelInstances::add(std::shared_ptr<const Model> model, const glm::mat4& transform) {
+    if (!model) {
+        return kInvalidInstance;
+    }
+    uint32_t slot;
+    auto found = modelSlots.find(model.get());
+    if (found != modelSlots.end()) {
+        slot = found->second;
+    } else {
+        if (!freeModels.empty()) {
+            slot = freeModels.back();
+            freeModels.pop_back();
+        } else {
+            slot = static_cast<uint32_t>(models.size());
+            models.emplace_back();
+        }
+        modelSlots[model.get()] = slot;
+        models[slot].model = std::move(model);
+    }
+    ++models[slot].instanceCount;
+
+    // the real bounds go in below once the instance's transform is stored
+    Instance instance = bvh.insert(Aabb());
+    if (instance >= instanceModel.size()) {
+        instanceModel.resize(instance + 1);
+        instanceTransform.resize(instance + 1);
+        instancePacked.resize(instance + 1);
+        instanceScale.resize(instance + 1);
+    }
+    instanceModel[instance] = slot;
+    setTransform(instance, transform);
+    return instance;
+}
+
+void ModelInstances::setTransform(Instance instance, const glm::mat4& transform) {
+    if (!contains(instance)) {
+        return;
+    }
+    instanceTransform[instance] = transform;
+    instancePacked[instance] = packInstanceTransform(transform);
+    instanceScale[instance] = maxAxisScale(transform);
+    bvh.update(instance, worldBounds(instance));
+}
+
+void ModelInstances::remove(Instance instance) {
+    if (!contains(instance)) {
+        return;
+    }
+    uint32_t slot = instanceModel[instance];
+    if (--models[slot].instanceCount == 0) {
+        modelSlots.erase(models[slot].model.get());
+        models[slot].model.reset();
+        freeModels.push_back(slot);
+    }
+    bvh.remove(instance);
+}
+
+Aabb ModelInstances::worldBounds(Instance instance) const {
+    return transformAabb(models[instanceModel[instance]].model->getBounds(), instanceTransform[instance]);
+}
+
+void ModelInstances::buildDrawList(const DrawListView& view, DrawList& list) {
+    list.clear();
+    bvh.commit();
+
+    visible.clear();
+    if (view.cull) {
+        bvh.queryFrustum(view.frustum, visible);
+    } else {
+        for (Instance instance = 0; instance < instanceModel.size(); ++instance) {
+            if (bvh.contains(instance)) {
+                visible.push_back(instance);
+            }
+        }
+    }
+
+    // counting sort by model, the visible instances of each model end up contiguous
+    modelStart.assign(models.size() + 1, 0);
+    for (Instance instance : visible) {
+        ++modelStart[instanceModel[instance] + 1];
+    }
+    for (size_t slot = 0; slot < models.size(); ++slot) {
+        modelStart[slot + 1] += modelStart[slot];
+    }
+    byModel.resize(visible.size());
+    slotFill.assign(modelStart.begin(), modelStart.end() - 1);
+    for (Instance instance : visible) {
+        byModel[slotFill[instanceModel[instance]]++] = instance;
+    }
+
+    for (size_t slot = 0; slot < models.size(); ++slot) {
+        uint32_t begin = modelStart[slot], end = modelStart[slot + 1];
+        if (begin == end) {
+            continue;
+        }
+        const Model& model = *models[slot].model;
+        const std::vector<Mesh>& meshes = model.getMeshes();
+        uint32_t count = end - begin;
+        // without LOD selection every mesh draws the same instances, one transform range serves all
+        uint32_t sharedFirst = UINT32_MAX;
+
+        for (uint32_t meshIndex = 0; meshIndex < meshes.size(); ++meshIndex) {
+            const Mesh& mesh = meshes[meshIndex];
+            if (mesh.lods.empty()) {
+                continue;
+            }
+            if (!view.selectLods || mesh.lods.size() == 1) {
+                if (sharedFirst == UINT32_MAX) {
+                    sharedFirst = static_cast<uint32_t>(list.transforms.size());
+                    for (uint32_t i = begin; i < end; ++i) {
+                        list.transforms.push_back(instancePacked[byModel[i]]);
+                    }
+                }
+                appendDraws(model, meshIndex, 0, sharedFirst, count, list.draws);
+                continue;
+            }
+
+            // level per instance from the distance to the closest point of its mesh sphere,
+            // then one transform range per level
+            size_t lodCount = mesh.lods.size();
+            instanceLod.resize(count);
+            lodStart.assign(lodCount + 1, 0);
+            for (uint32_t i = 0; i < count; ++i) {
+                Instance instance = byModel[begin + i];
+                float scale = instanceScale[instance];
+                glm::vec3 center = transformPoint(instanceTransform[instance], mesh.sphere.center);
+                float distance = std::max(glm::length(center - view.camera) - mesh.sphere.radius * scale, 1e-6f);
+                size_t lod = scale > 0.0f ? selectLod(mesh, distance / scale, view.projectionScale, view.maxPixelError) : lodCount - 1;
+                instanceLod[i] = static_cast<uint32_t>(lod);
+                ++lodStart[lod + 1];
+            }
+            for (size_t lod = 0; lod < lodCount; ++lod) {
+                lodStart[lod + 1] += lodStart[lod];
+            }
+            uint32_t first = static_cast<uint32_t>(list.transforms.size());
+            list.transforms.resize(first + count);
+            slotFill.assign(lodStart.begin(), lodStart.end() - 1);
+            for (uint32_t i = 0; i < count; ++i) {
+                list.transforms[first + slotFill[instanceLod[i]]++] = instancePacked[byModel[begin + i]];
+            }
+            for (uint32_t lod = 0; lod < lodCount; ++lod) {
+                if (lodStart[lod + 1] != lodStart[lod]) {
+                    appendDraws(model, meshIndex, lod, first + lodStart[lod], lodStart[lod + 1] - lodStart[lod], list.draws);
+                }
+            }
+        }
+    }
+}
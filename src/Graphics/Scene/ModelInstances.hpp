@@ -0,0 +1,110 @@
+#ifndef MODELINSTANCES_HPP
+#define MODELINSTANCES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Graphics/Objects/Model.hpp"
+#include "SceneBvh.hpp"
+
+// placements of shared models, many instances of one Model reference its meshes and
+// the GPU vertex / index data uploaded for them once
+//
+// once a frame buildDrawList() culls the instances through a SceneBvh, groups the visible
+// ones by model, mesh and level of detail, and writes their transforms back to back into
+// DrawList::transforms, one upload for the frame; each material range of a group becomes
+// one InstancedDraw, so a hundred copies of an asset cost a draw per submesh, not a hundred
+
+// object to world transform as the three rows of a row major 3x4 matrix (the last row of an
+// affine transform is always 0 0 0 1), reads as a mat3x4 / float3x4 in std430 buffers
+struct InstanceTransform {
+    glm::vec4 rows[3];
+};
+static_assert(sizeof(InstanceTransform) == 48, "InstanceTransform must stay 48 bytes");
+
+InstanceTransform packInstanceTransform(const glm::mat4& transform);
+
+// one vkCmdDrawIndexed(indexCount, instanceCount, indexOffset, 0, firstInstance) with the
+// model's buffers for mesh bound and the pipeline for material
+struct InstancedDraw {
+    const Model* model;
+    uint32_t mesh;
+    uint32_t lod;
+    uint32_t material;  // index into model->getMaterials()
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    uint32_t firstInstance;  // into DrawList::transforms
+    uint32_t instanceCount;
+};
+
+struct DrawList {
+    std::vector<InstanceTransform> transforms;
+    std::vector<InstancedDraw> draws;
+
+    void clear() {
+        transforms.clear();
+        draws.clear();
+    }
+    size_t transformBytes() const { return transforms.size() * sizeof(InstanceTransform); }
+};
+
+// how a frame looks at the instances, the defaults draw everything at full detail
+struct DrawListView {
+    bool cull = false;
+    Frustum frustum{};
+    // per instance and mesh level of detail from the distance to camera, see MeshLod.hpp
+    bool selectLods = false;
+    glm::vec3 camera = glm::vec3(0.0f);
+    float projectionScale = 1.0f;  // lodProjectionScale()
+    float maxPixelError = 1.0f;
+};
+
+class ModelInstances {
+public:
+    using Instance = SceneBvh::InstanceId;
+    static constexpr Instance kInvalidInstance = SceneBvh::kInvalidInstance;
+
+    // the model stays alive while any of its instances does, ids of removed instances are reused
+    Instance add(std::shared_ptr<const Model> model, const glm::mat4& transform);
+    void setTransform(Instance instance, const glm::mat4& transform);
+    void remove(Instance instance);
+    bool contains(Instance instance) const { return bvh.contains(instance); }
+    size_t size() const { return bvh.size(); }
+    // distinct models with at least one instance
+    size_t modelCount() const { return modelSlots.size(); }
+
+    // commits the moves since the last call to the BVH and fills list (cleared first)
+    void buildDrawList(const DrawListView& view, DrawList& list);
+
+private:
+    struct ModelSlot {
+        std::shared_ptr<const Model> model;
+        size_t instanceCount = 0;
+    };
+    std::vector<ModelSlot> models;
+    std::vector<uint32_t> freeModels;
+    std::unordered_map<const Model*, uint32_t> modelSlots;
+
+    // indexed by instance id
+    std::vector<uint32_t> instanceModel;
+    std::vector<glm::mat4> instanceTransform;
+    std::vector<InstanceTransform> instancePacked;
+    std::vector<float> instanceScale;  // largest axis scale, for LOD errors and mesh spheres
+    SceneBvh bvh;
+
+    // per frame scratch, kept to avoid reallocating
+    std::vector<Instance> visible;
+    std::vector<uint32_t> modelStart;
+    std::vector<Instance> byModel;
+    std::vector<uint32_t> instanceLod;
+    std::vector<uint32_t> lodStart;
+    std::vector<uint32_t> slotFill;
+
+    Aabb worldBounds(Instance instance) const;
+};
+
+#endif // MODELINSTANCES_HPP
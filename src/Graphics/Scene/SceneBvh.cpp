@@ -0,0 +1,344 @@
+#include "SceneBvh.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr int kSahBins = 16;
+    constexpr uint32_t kNoNode = UINT32_MAX;
+
+    struct BuildTask {
+        uint32_t node;
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    struct SahBin {
+        Aabb bounds;
+        uint32_t count = 0;
+    };
+}
+
+SceneBvh::InstanceId SceneBvh::insert(const Aabb& bounds) {
+    InstanceId instance;
+    if (!freeInstances.empty()) {
+        instance = freeInstances.back();
+        freeInstances.pop_back();
+    } else {
+        instance = static_cast<InstanceId>(instanceBounds.size());
+        instanceBounds.emplace_back();
+        instanceLeaf.push_back(kNoNode);
+        instanceAlive.push_back(0);
+    }
+    instanceBounds[instance] = bounds;
+    instanceLeaf[instance] = kNoNode;
+    instanceAlive[instance] = 1;
+    ++instanceCount;
+    structureChanged = true;
+    return instance;
+}
+
+void SceneBvh::update(InstanceId instance, const Aabb& bounds) {
+    if (!contains(instance)) {
+        return;
+    }
+    instanceBounds[instance] = bounds;
+    if (!structureChanged && instanceLeaf[instance] != kNoNode) {
+        movedInstances.push_back(instance);
+    }
+}
+
+void SceneBvh::remove(InstanceId instance) {
+    if (!contains(instance)) {
+        return;
+    }
+    instanceAlive[instance] = 0;
+    instanceLeaf[instance] = kNoNode;
+    freeInstances.push_back(instance);
+    --instanceCount;
+    structureChanged = true;
+}
+
+bool SceneBvh::contains(InstanceId instance) const {
+    return instance < instanceAlive.size() && instanceAlive[instance];
+}
+
+void SceneBvh::commit() {
+    if (structureChanged) {
+        build();
+        return;
+    }
+    if (!movedInstances.empty()) {
+        refit();
+        if (cost() > builtCost * kRebuildCostRatio) {
+            build();
+        }
+    }
+}
+
+double SceneBvh::nodeWeight(const Node& node) const {
+    return static_cast<double>(node.count == 0 ? 1u : node.count) * node.bounds.halfArea();
+}
+
+float SceneBvh::cost() const {
+    if (nodes.empty()) {
+        return 0.0f;
+    }
+    float rootArea = nodes[0].bounds.halfArea();
+    return rootArea > 0.0f ? static_cast<float>(areaSum / rootArea) : 0.0f;
+}
+
+void SceneBvh::build() {
+    nodes.clear();
+    parents.clear();
+    leafInstances.clear();
+    movedInstances.clear();
+    structureChanged = false;
+    areaSum = 0.0;
+    builtCost = 0.0f;
+
+    for (InstanceId instance = 0; instance < instanceAlive.size(); ++instance) {
+        if (instanceAlive[instance]) {
+            leafInstances.push_back(instance);
+        }
+    }
+    dirtyNodes.clear();
+    if (leafInstances.empty()) {
+        return;
+    }
+
+    std::vector<glm::vec3> centers(instanceBounds.size());
+    for (InstanceId instance : leafInstances) {
+        centers[instance] = instanceBounds[instance].center();
+    }
+
+    nodes.emplace_back();
+    parents.push_back(kNoNode);
+    std::vector<BuildTask> tasks = {{0, 0, static_cast<uint32_t>(leafInstances.size())}};
+    while (!tasks.empty()) {
+        BuildTask task = tasks.back();
+        tasks.pop_back();
+
+        Aabb bounds, centerBounds;
+        for (uint32_t i = task.begin; i < task.end; ++i) {
+            bounds.grow(instanceBounds[leafInstances[i]]);
+            centerBounds.grow(centers[leafInstances[i]]);
+        }
+        nodes[task.node].bounds = bounds;
+        uint32_t count = task.end - task.begin;
+
+        // binned SAH over the instance centers, cost of a split is
+        // leftArea * leftCount + rightArea * rightCount against nodeArea * count for a leaf
+        float bestCost = static_cast<float>(count) * bounds.halfArea();
+        int bestAxis = -1;
+        int bestBin = 0;
+        glm::vec3 centerExtent = centerBounds.extent();
+        if (count > 1) {
+            for (int axis = 0; axis < 3; ++axis) {
+                if (centerExtent[axis] <= 0.0f) {
+                    continue;
+                }
+                SahBin bins[kSahBins];
+                float scale = kSahBins / centerExtent[axis];
+                for (uint32_t i = task.begin; i < task.end; ++i) {
+                    InstanceId instance = leafInstances[i];
+                    int bin = std::min(kSahBins - 1, static_cast<int>((centers[instance][axis] - centerBounds.minimum[axis]) * scale));
+                    bins[bin].bounds.grow(instanceBounds[instance]);
+                    ++bins[bin].count;
+                }
+                // right to left sweep first, then test every cut on the left to right sweep
+                float rightCost[kSahBins];
+                Aabb right;
+                uint32_t rightCount = 0;
+                for (int bin = kSahBins - 1; bin > 0; --bin) {
+                    right.grow(bins[bin].bounds);
+                    rightCount += bins[bin].count;
+                    rightCost[bin] = static_cast<float>(rightCount) * right.halfArea();
+                }
+                Aabb left;
+                uint32_t leftCount = 0;
+                for (int bin = 0; bin < kSahBins - 1; ++bin) {
+                    left.grow(bins[bin].bounds);
+                    leftCount += bins[bin].count;
+                    if (leftCount == 0 || leftCount == count) {
+                        continue;
+                    }
+                    float splitCost = static_cast<float>(leftCount) * left.halfArea() + rightCost[bin + 1];
+                    if (splitCost < bestCost) {
+                        bestCost = splitCost;
+                        bestAxis = axis;
+                        bestBin = bin;
+                    }
+                }
+            }
+        }
+
+        uint32_t middle;
+        if (bestAxis >= 0) {
+            float scale = kSahBins / centerExtent[bestAxis];
+            float minimum = centerBounds.minimum[bestAxis];
+            auto split = std::partition(leafInstances.begin() + task.begin, leafInstances.begin() + task.end, [&](InstanceId instance) {
+                return std::min(kSahBins - 1, static_cast<int>((centers[instance][bestAxis] - minimum) * scale)) <= bestBin;
+            });
+            middle = static_cast<uint32_t>(split - leafInstances.begin());
+        } else if (count > kMaxLeafInstances) {
+            // no cut helps (stacked centers), halve it anyway to keep leaves small
+            middle = task.begin + count / 2;
+        } else {
+            nodes[task.node].first = task.begin;
+            nodes[task.node].count = count;
+            for (uint32_t i = task.begin; i < task.end; ++i) {
+                instanceLeaf[leafInstances[i]] = task.node;
+            }
+            continue;
+        }
+
+        uint32_t leftChild = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+        nodes.emplace_back();
+        parents.push_back(task.node);
+        parents.push_back(task.node);
+        nodes[task.node].first = leftChild;
+        nodes[task.node].count = 0;
+        tasks.push_back({leftChild, task.begin, middle});
+        tasks.push_back({leftChild + 1, middle, task.end});
+    }
+
+    for (const Node& node : nodes) {
+        areaSum += nodeWeight(node);
+    }
+    builtCost = cost();
+    dirtyNodes.assign(nodes.size(), 0);
+}
+
+void SceneBvh::refitNode(uint32_t index) {
+    Node& node = nodes[index];
+    areaSum -= nodeWeight(node);
+    Aabb bounds;
+    if (node.count == 0) {
+        bounds = nodes[node.first].bounds;
+        bounds.grow(nodes[node.first + 1].bounds);
+    } else {
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            bounds.grow(instanceBounds[leafInstances[i]]);
+        }
+    }
+    node.bounds = bounds;
+    areaSum += nodeWeight(node);
+}
+
+void SceneBvh::refit() {
+    if (structureChanged) {
+        build();
+        return;
+    }
+    // every node on the paths from moved leaves to the root, each once
+    std::vector<uint32_t> dirty;
+    for (InstanceId instance : movedInstances) {
+        if (!contains(instance)) {
+            continue;
+        }
+        for (uint32_t node = instanceLeaf[instance]; node != kNoNode && !dirtyNodes[node]; node = parents[node]) {
+            dirtyNodes[node] = 1;
+            dirty.push_back(node);
+        }
+    }
+    movedInstances.clear();
+
+    // children come after their parent, so deepest first is highest index first
+    std::sort(dirty.begin(), dirty.end(), std::greater<uint32_t>());
+    for (uint32_t node : dirty) {
+        refitNode(node);
+        dirtyNodes[node] = 0;
+    }
+}
+
+void SceneBvh::queryFrustum(const Frustum& frustum, std::vector<InstanceId>& visible) const {
+    if (nodes.empty()) {
+        return;
+    }
+    // second member set once a node is known to be inside, its subtree is then taken whole
+    std::vector<std::pair<uint32_t, bool>> stack = {{0, false}};
+    while (!stack.empty()) {
+        auto [index, inside] = stack.back();
+        stack.pop_back();
+        const Node& node = nodes[index];
+        if (!inside) {
+            FrustumTest test = testAabb(frustum, node.bounds);
+            if (test == FrustumTest::Outside) {
+                continue;
+            }
+            inside = test == FrustumTest::Inside;
+        }
+        if (node.count == 0) {
+            stack.push_back({node.first, inside});
+            stack.push_back({node.first + 1, inside});
+            continue;
+        }
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            InstanceId instance = leafInstances[i];
+            if (inside || testAabb(frustum, instanceBounds[instance]) != FrustumTest::Outside) {
+                visible.push_back(instance);
+            }
+        }
+    }
+}
+
+bool SceneBvh::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit, const RayTest& exact) const {
+    if (nodes.empty()) {
+        return false;
+    }
+    glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    float best = maxDistance;
+    bool found = false;
+
+    float rootNear;
+    if (!intersectRayAabb(origin, inverseDirection, nodes[0].bounds, best, rootNear)) {
+        return false;
+    }
+    std::vector<std::pair<uint32_t, float>> stack = {{0, rootNear}};
+    while (!stack.empty()) {
+        auto [index, nodeNear] = stack.back();
+        stack.pop_back();
+        if (nodeNear > best) {
+            continue;
+        }
+        const Node& node = nodes[index];
+        if (node.count != 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                InstanceId instance = leafInstances[i];
+                float boxNear;
+                if (!intersectRayAabb(origin, inverseDirection, instanceBounds[instance], best, boxNear)) {
+                    continue;
+                }
+                float distance = exact ? exact(instance) : boxNear;
+                if (distance >= 0.0f && distance <= best) {
+                    best = distance;
+                    hit.instance = instance;
+                    hit.distance = distance;
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        // the nearer child goes on top so it is searched first and shrinks best early
+        float nearA, nearB;
+        bool hitA = intersectRayAabb(origin, inverseDirection, nodes[node.first].bounds, best, nearA);
+        bool hitB = intersectRayAabb(origin, inverseDirection, nodes[node.first + 1].bounds, best, nearB);
+        if (hitA && hitB) {
+            if (nearA < nearB) {
+                stack.push_back({node.first + 1, nearB});
+                stack.push_back({node.first, nearA});
+            } else {
+                stack.push_back({node.first, nearA});
+                stack.push_back({node.first + 1, nearB});
+            }
+        } else if (hitA) {
+            stack.push_back({node.first, nearA});
+        } else if (hitB) {
+            stack.push_back({node.first + 1, nearB});
+        }
+    }
+    return found;
+}
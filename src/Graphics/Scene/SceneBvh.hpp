@@ -0,0 +1,88 @@
+#ifndef SCENEBVH_HPP
+#define SCENEBVH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Graphics/Objects/Bounds.hpp"
+
+// bounding volume hierarchy over scene instances (world space boxes with an id)
+// for frustum culling and ray / controller picking in logarithmic time
+//
+// build() makes a binned SAH tree; a moving instance only refits the boxes on its path
+// to the root. insert / update / remove only record the change, commit() applies them
+// once a frame: a refit for moves, a full build when instances were added or removed or
+// when refits grew the SAH cost past kRebuildCostRatio times what the last build gave
+
+class SceneBvh {
+public:
+    using InstanceId = uint32_t;
+    static constexpr InstanceId kInvalidInstance = UINT32_MAX;
+    // refits loosen the tree as instances move apart, rebuild past this much extra cost
+    static constexpr float kRebuildCostRatio = 1.5f;
+    static constexpr uint32_t kMaxLeafInstances = 4;
+
+    struct RayHit {
+        InstanceId instance = kInvalidInstance;
+        float distance = 0.0f;
+    };
+    // exact test for an instance whose box the ray enters, returns the hit distance or
+    // a negative number for a miss
+    using RayTest = std::function<float(InstanceId instance)>;
+
+    // ids of removed instances are reused
+    InstanceId insert(const Aabb& bounds);
+    void update(InstanceId instance, const Aabb& bounds);
+    void remove(InstanceId instance);
+    bool contains(InstanceId instance) const;
+    const Aabb& bounds(InstanceId instance) const { return instanceBounds[instance]; }
+    size_t size() const { return instanceCount; }
+
+    // applies the changes since the last commit, refit or rebuild as described above
+    void commit();
+    void build();
+    void refit();
+
+    // appends every instance whose box is not entirely outside the frustum
+    void queryFrustum(const Frustum& frustum, std::vector<InstanceId>& visible) const;
+    // nearest instance along the ray within maxDistance, boxes are visited near to far and
+    // skipped once they start behind the best hit; without exact the box entry is the hit
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit, const RayTest& exact = nullptr) const;
+
+    // surface area heuristic cost relative to the root, lower is a better tree
+    float cost() const;
+
+private:
+    // leaves hold count instances from leafInstances[first], inner nodes have count 0 and
+    // their children at first and first + 1, children always come after their parent
+    struct Node {
+        Aabb bounds;
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<uint32_t> parents;
+    std::vector<InstanceId> leafInstances;
+
+    std::vector<Aabb> instanceBounds;
+    std::vector<uint32_t> instanceLeaf;  // leaf node of each instance, UINT32_MAX when removed
+    std::vector<uint8_t> instanceAlive;
+    std::vector<InstanceId> freeInstances;
+    size_t instanceCount = 0;
+
+    std::vector<InstanceId> movedInstances;
+    std::vector<uint8_t> dirtyNodes;
+    bool structureChanged = false;
+    // sum of node areas weighted like cost(), kept up to date by refit
+    double areaSum = 0.0;
+    float builtCost = 0.0f;
+
+    double nodeWeight(const Node& node) const;
+    void refitNode(uint32_t node);
+};
+
+#endif // SCENEBVH_HPP
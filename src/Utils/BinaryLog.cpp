@@ -0,0 +1,191 @@
+#include "BinaryLog.hpp"
+
+#include <cstring>
+
+static void writeVarint(std::string &out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+static void writeBytes(std::string &out, std::string_view bytes)
+{
+    writeVarint(out, bytes.size());
+    out.append(bytes.data(), bytes.size());
+}
+
+void BinaryLogEncoder::begin(std::string &out, int64_t wallClockStartNs, uint64_t monotonicStartNs,
+                             const char *const *tagNames, size_t tagCount)
+{
+    fileIds_.clear();
+    nextStringId_ = 0;
+    lastTimeNs_ = monotonicStartNs;
+
+    BinaryLogHeader header{};
+    std::memcpy(header.magic, kBinaryLogMagic, sizeof(header.magic));
+    header.version = kBinaryLogVersion;
+    header.flags = 0;
+    header.wallClockStartNs = wallClockStartNs;
+    header.monotonicStartNs = monotonicStartNs;
+    out.append(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    for (size_t i = 0; i < tagCount && i < 64; ++i)
+    {
+        out.push_back(static_cast<char>(BinaryLogChunk::Tag));
+        writeVarint(out, i);
+        writeBytes(out, tagNames[i]);
+    }
+}
+
+void BinaryLogEncoder::appendEntry(std::string &out, uint64_t timeNs, int level, const char *file, int line,
+                                   uint64_t tagMask, std::string_view message)
+{
+    auto it = fileIds_.find(file);
+    uint32_t fileId;
+    if (it == fileIds_.end())
+    {
+        fileId = nextStringId_++;
+        fileIds_.emplace(file, fileId);
+        out.push_back(static_cast<char>(BinaryLogChunk::String));
+        writeVarint(out, fileId);
+        writeBytes(out, file);
+    }
+    else
+    {
+        fileId = it->second;
+    }
+
+    // records from several threads can arrive slightly out of order, clamp so the delta stays unsigned
+    uint64_t delta = timeNs > lastTimeNs_ ? timeNs - lastTimeNs_ : 0;
+    lastTimeNs_ += delta;
+
+    out.push_back(static_cast<char>(BinaryLogChunk::Entry));
+    writeVarint(out, delta);
+    out.push_back(static_cast<char>(level));
+    writeVarint(out, fileId);
+    writeVarint(out, static_cast<uint64_t>(line + 1));
+    writeVarint(out, tagMask);
+    writeBytes(out, message);
+}
+
+BinaryLogDecoder::BinaryLogDecoder(const uint8_t *data, size_t size)
+    : data_(data), size_(size), pos_(0), valid_(false), truncated_(false), header_{}, lastTimeNs_(0)
+{
+    if (size_ < sizeof(BinaryLogHeader))
+        return;
+    std::memcpy(&header_, data_, sizeof(BinaryLogHeader));
+    if (std::memcmp(header_.magic, kBinaryLogMagic, sizeof(kBinaryLogMagic)) != 0 || header_.version != kBinaryLogVersion)
+        return;
+    pos_ = sizeof(BinaryLogHeader);
+    lastTimeNs_ = header_.monotonicStartNs;
+    valid_ = true;
+}
+
+bool BinaryLogDecoder::readVarint(uint64_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (pos_ >= size_)
+            return false;
+        uint8_t byte = data_[pos_++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+bool BinaryLogDecoder::readBytes(size_t length, std::string_view &bytes)
+{
+    if (length > size_ - pos_)
+        return false;
+    bytes = std::string_view(reinterpret_cast<const char *>(data_ + pos_), length);
+    pos_ += length;
+    return true;
+}
+
+bool BinaryLogDecoder::next(BinaryLogEntry &entry)
+{
+    if (!valid_)
+        return false;
+
+    while (pos_ < size_)
+    {
+        size_t chunkStart = pos_;
+        BinaryLogChunk chunk = static_cast<BinaryLogChunk>(data_[pos_++]);
+        uint64_t id = 0, length = 0;
+        std::string_view bytes;
+
+        switch (chunk)
+        {
+        case BinaryLogChunk::End:
+            return false;
+
+        case BinaryLogChunk::String:
+            if (!readVarint(id) || !readVarint(length) || !readBytes(length, bytes))
+                break;
+            if (strings_.size() <= id)
+                strings_.resize(id + 1);
+            strings_[id] = std::string(bytes);
+            continue;
+
+        case BinaryLogChunk::Tag:
+            if (!readVarint(id) || !readVarint(length) || !readBytes(length, bytes) || id >= 64)
+                break;
+            tagNames_[id] = std::string(bytes);
+            continue;
+
+        case BinaryLogChunk::Entry:
+        {
+            uint64_t delta = 0, fileId = 0, line = 0, tagMask = 0;
+            if (!readVarint(delta) || pos_ >= size_)
+                break;
+            int level = data_[pos_++];
+            if (!readVarint(fileId) || !readVarint(line) || !readVarint(tagMask) || !readVarint(length) || !readBytes(length, bytes))
+                break;
+
+            lastTimeNs_ += delta;
+            entry.timeNs = lastTimeNs_;
+            entry.level = level;
+            entry.line = static_cast<int>(line) - 1;
+            entry.tagMask = tagMask;
+            entry.file = fileId < strings_.size() ? std::string_view(strings_[fileId]) : std::string_view();
+            entry.message = bytes;
+            return true;
+        }
+
+        default:
+            break;
+        }
+
+        // unknown or cut off chunk, typically the tail of a log from a crashed run
+        pos_ = chunkStart;
+        truncated_ = true;
+        return false;
+    }
+    return false;
+}
+
+std::string BinaryLogDecoder::tagNames(uint64_t tagMask) const
+{
+    std::string names;
+    for (int i = 0; i < 64; ++i)
+    {
+        if (tagMask & (1ull << i))
+        {
+            names += tagNames_[i].empty() ? "Tag" + std::to_string(i) : tagNames_[i];
+            names += ' ';
+        }
+    }
+    return names;
+}
+
+int64_t BinaryLogDecoder::wallClockNs(uint64_t timeNs) const
+{
+    return header_.wallClockStartNs + static_cast<int64_t>(timeNs - header_.monotonicStartNs);
+}
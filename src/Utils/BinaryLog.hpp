@@ -0,0 +1,104 @@
+#ifndef BINARYLOG_HPP
+#define BINARYLOG_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// compact on-disk log format written by Logger when BINARY_LOGGING is set
+// rendered back into html / text by the VRLogConvert tool
+//
+// layout:
+//   BinaryLogHeader (32 bytes, little endian)
+//   sequence of chunks, each starting with a BinaryLogChunk byte
+//     String  : varint id, varint length, bytes     (file names)
+//     Tag     : varint bit, varint length, bytes    (tag names)
+//     Entry   : varint time delta ns, u8 level, varint file id,
+//               varint line + 1, varint tag mask, varint length, bytes
+//     End     : zero byte, anything after it is padding
+// entry timestamps are monotonic nanoseconds, stored as the delta from the
+// previous entry (the first one from header.monotonicStartNs)
+
+inline constexpr char kBinaryLogMagic[8] = {'V', 'R', 'L', 'O', 'G', '\0', '\0', '\0'};
+inline constexpr uint32_t kBinaryLogVersion = 1;
+
+struct BinaryLogHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    int64_t wallClockStartNs;  // system clock at monotonicStartNs, used to print times of day
+    uint64_t monotonicStartNs; // steady clock when the file was started
+};
+static_assert(sizeof(BinaryLogHeader) == 32, "BinaryLogHeader must stay 32 bytes");
+
+enum class BinaryLogChunk : uint8_t
+{
+    End = 0,
+    String = 1,
+    Tag = 2,
+    Entry = 3
+};
+
+struct BinaryLogEntry
+{
+    uint64_t timeNs = 0; // monotonic
+    int level = 0;
+    int line = -1;
+    uint64_t tagMask = 0;
+    std::string_view file;
+    std::string_view message;
+};
+
+class BinaryLogEncoder
+{
+public:
+    // writes the header and tag table and resets the string table
+    void begin(std::string &out, int64_t wallClockStartNs, uint64_t monotonicStartNs,
+               const char *const *tagNames, size_t tagCount);
+    // file must outlive the encoder (__FILE__ literals), it is interned by pointer
+    void appendEntry(std::string &out, uint64_t timeNs, int level, const char *file, int line,
+                     uint64_t tagMask, std::string_view message);
+
+private:
+    std::unordered_map<const char *, uint32_t> fileIds_;
+    uint32_t nextStringId_ = 0;
+    uint64_t lastTimeNs_ = 0;
+};
+
+class BinaryLogDecoder
+{
+public:
+    BinaryLogDecoder(const uint8_t *data, size_t size);
+
+    bool valid() const { return valid_; }
+    const BinaryLogHeader &header() const { return header_; }
+
+    // returns false once the end marker, the end of data, or a damaged chunk is reached
+    bool next(BinaryLogEntry &entry);
+    // true if decoding stopped on a damaged or cut off chunk rather than a clean end
+    bool truncated() const { return truncated_; }
+
+    // space separated tag names, matching the html data-tags attribute
+    std::string tagNames(uint64_t tagMask) const;
+    int64_t wallClockNs(uint64_t timeNs) const;
+
+private:
+    const uint8_t *data_;
+    size_t size_;
+    size_t pos_;
+    bool valid_;
+    bool truncated_;
+    BinaryLogHeader header_;
+    uint64_t lastTimeNs_;
+    std::vector<std::string> strings_;
+    std::string tagNames_[64];
+
+    bool readVarint(uint64_t &value);
+    bool readBytes(size_t length, std::string_view &bytes);
+};
+
+#endif // BINARYLOG_HPP
@@ -0,0 +1,48 @@
+#include "Hash.hpp"
+
+#include <cstring>
+
+namespace
+{
+    uint64_t rotl(uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+}
+
+uint64_t hashBytes(const uint8_t *data, size_t size)
+{
+    constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+    constexpr uint64_t kPrime3 = 0x165667B19E3779F9ull;
+
+    uint64_t lanes[4] = {kPrime1 + kPrime2, kPrime2, 0, 0 - kPrime1};
+    size_t offset = 0;
+    for (; offset + 32 <= size; offset += 32)
+    {
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            uint64_t word;
+            std::memcpy(&word, data + offset + lane * 8, 8);
+            lanes[lane] = rotl(lanes[lane] + word * kPrime2, 31) * kPrime1;
+        }
+    }
+    uint64_t hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18) + size;
+    for (; offset + 8 <= size; offset += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, data + offset, 8);
+        hash = rotl(hash ^ (rotl(word * kPrime2, 31) * kPrime1), 27) * kPrime1 + kPrime3;
+    }
+    for (; offset < size; ++offset)
+    {
+        hash = rotl(hash ^ (data[offset] * kPrime3), 11) * kPrime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+    return hash;
+}
@@ -0,0 +1,11 @@
+#ifndef HASH_HPP
+#define HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// 64 bit content hash for cache keys and file checksums, reads 8 byte words on
+// four independent lanes, the value is stored on disk so it must never change
+uint64_t hashBytes(const uint8_t *data, size_t size);
+
+#endif // HASH_HPP
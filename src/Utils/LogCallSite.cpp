@@ -0,0 +1,79 @@
+#include "LogCallSite.hpp"
+#include "Utils.hpp"
+
+#include <chrono>
+
+std::atomic<LogCallSite *> LogCallSite::throttledSites_{nullptr};
+
+uint64_t LogCallSite::nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool LogCallSite::admitSlow(uint32_t count, int level, uint64_t tagMask, const char *file, int line)
+{
+    if (count == kLogSiteBurst && !registered_.load(std::memory_order_acquire))
+    {
+        level_ = level;
+        line_ = line;
+        tagMask_ = tagMask;
+        file_ = file;
+        if (!registered_.exchange(true, std::memory_order_acq_rel))
+        {
+            LogCallSite *head = throttledSites_.load(std::memory_order_relaxed);
+            do
+            {
+                next_ = head;
+            } while (!throttledSites_.compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_relaxed));
+        }
+    }
+
+    // async: only look at the clock on the first call over the limit and then every
+    // 64 dropped calls, the writer sweep reports sites that go quiet in between
+    // sync has no sweep, so every dropped call checks whether its window is over
+    if (ASYNC_LOGGING && count != kLogSiteBurst && count % 64 != 0)
+        return false;
+
+    uint64_t now = nowNs();
+    uint64_t windowStart = windowStartNs_.load(std::memory_order_relaxed);
+    if (now - windowStart < kLogSiteWindowNs)
+        return false;
+
+    // window is over, this call opens the next one and reports what was dropped
+    uint32_t previousCount = 0;
+    if (!rollWindow(windowStart, now, 1, previousCount))
+        return false;
+    if (previousCount > kLogSiteBurst + 1)
+        reportSuppressed(previousCount - kLogSiteBurst - 1, now - windowStart);
+    return true;
+}
+
+bool LogCallSite::rollWindow(uint64_t windowStart, uint64_t now, uint32_t keep, uint32_t &previousCount)
+{
+    if (!windowStartNs_.compare_exchange_strong(windowStart, now, std::memory_order_relaxed))
+        return false;
+    previousCount = count_.exchange(keep, std::memory_order_relaxed);
+    return true;
+}
+
+void LogCallSite::reportSuppressed(uint32_t suppressed, uint64_t elapsedNs)
+{
+    logMessageInternal(level_, std::to_string(suppressed) + " messages suppressed in " + std::to_string(elapsedNs / 1000000) + " ms",
+                       LogTags(tagMask_), file_, line_);
+}
+
+void LogCallSite::flushSuppressed(bool force)
+{
+    uint64_t now = nowNs();
+    for (LogCallSite *site = throttledSites_.load(std::memory_order_acquire); site != nullptr; site = site->next_)
+    {
+        if (site->count_.load(std::memory_order_relaxed) <= kLogSiteBurst)
+            continue;
+        uint64_t windowStart = site->windowStartNs_.load(std::memory_order_relaxed);
+        if (!force && now - windowStart < kLogSiteWindowNs)
+            continue;
+        uint32_t previousCount = 0;
+        if (site->rollWindow(windowStart, now, 0, previousCount) && previousCount > kLogSiteBurst)
+            site->reportSuppressed(previousCount - kLogSiteBurst, now - windowStart);
+    }
+}
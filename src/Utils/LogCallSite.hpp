@@ -0,0 +1,64 @@
+#ifndef LOGCALLSITE_HPP
+#define LOGCALLSITE_HPP
+
+#include <atomic>
+#include <cstdint>
+
+// per call site rate limiter, the logMessage macro keeps one of these as a
+// function local static next to every call
+// the first kLogSiteBurst calls of a window pass on a single atomic increment,
+// later ones are counted and dropped before the message is built, then reported
+// as "N messages suppressed in T ms" once the window rolls over; the messages of
+// one site may all differ, so the summary only counts them
+// errors (level 1) are never throttled
+
+inline constexpr uint32_t kLogSiteBurst = 16;
+inline constexpr uint64_t kLogSiteWindowNs = 1000000000ull; // 1 s
+
+class LogCallSite
+{
+public:
+    constexpr LogCallSite() = default;
+
+    bool admit(int level, uint64_t tagMask, const char *file, int line)
+    {
+        if (level <= 1)
+            return true;
+        uint32_t count = count_.fetch_add(1, std::memory_order_relaxed);
+        if (count == 0)
+        {
+            windowStartNs_.store(nowNs(), std::memory_order_relaxed);
+            return true;
+        }
+        if (count < kLogSiteBurst)
+            return true;
+        return admitSlow(count, level, tagMask, file, line);
+    }
+
+    // reports suppressed calls of every throttled site whose window has ended
+    // force reports all of them regardless of window, used on shutdown
+    static void flushSuppressed(bool force);
+
+    static uint64_t nowNs();
+
+private:
+    std::atomic<uint32_t> count_{0};
+    std::atomic<uint64_t> windowStartNs_{0};
+
+    // filled in when the site is first throttled so summaries can be written later
+    int level_ = 0;
+    int line_ = -1;
+    uint64_t tagMask_ = 0;
+    const char *file_ = "";
+    std::atomic<bool> registered_{false};
+    LogCallSite *next_ = nullptr;
+
+    static std::atomic<LogCallSite *> throttledSites_;
+
+    bool admitSlow(uint32_t count, int level, uint64_t tagMask, const char *file, int line);
+    // resets the window if it started at windowStart, returns false if another thread won
+    bool rollWindow(uint64_t windowStart, uint64_t now, uint32_t keep, uint32_t &previousCount);
+    void reportSuppressed(uint32_t suppressed, uint64_t elapsedNs);
+};
+
+#endif // LOGCALLSITE_HPP
@@ -0,0 +1,89 @@
+#include "LogFormat.hpp"
+
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+const char *const kLogLevelTags[4] = {"ERR ", "WARN", "STEP", "INFO"};
+
+static const char *levelTag(int level)
+{
+    level = level < 1 ? 1 : (level > 4 ? 4 : level);
+    return kLogLevelTags[level - 1];
+}
+
+std::string formatLogTime(int64_t wallClockNs)
+{
+    std::time_t seconds = static_cast<std::time_t>(wallClockNs / 1000000000);
+    std::stringstream timeStream;
+    timeStream << std::put_time(std::localtime(&seconds), "%X");
+    return timeStream.str();
+}
+
+void writeHtmlLogHeader(std::ostream &out, const std::string &title)
+{
+    out << "<html><head><title>Log File</title><link rel=\"stylesheet\" href=\"logs.css\"><script src=\"logs.js\"></script></head><body>\n";
+    out << "<h1>Log " << title << "</h1>\n";
+}
+
+void writeHtmlLogEntry(std::ostream &out, int level, const std::string &tags, const std::string &file, int line,
+                       const std::string &time, const std::string &message)
+{
+    std::string htmlMessage = message;
+    size_t pos = 0;
+    while ((pos = htmlMessage.find('\n', pos)) != std::string::npos)
+    {
+        htmlMessage.replace(pos, 1, "<br>");
+        pos += 4; // length of <br>
+    }
+
+    out << "<div class=\"log-entry level-" << level << "\" data-tags=\"" << tags << "\"";
+    out << " data-file=\"" << file << "\"";
+    if (line != -1)
+    {
+        out << " data-line=\"" << line << "\"";
+    }
+    out << ">";
+    out << "<div class=\"time\">[" << time << "]</div> ";
+    out << "<div class=\"level-tag\">[" << levelTag(level) << "]</div> ";
+    out << "<div class=\"message\">" << htmlMessage << "</div>";
+    out << "</div>\n";
+}
+
+void writeHtmlLogFooter(std::ostream &out)
+{
+    out << "</body></html>\n";
+}
+
+void writeTextLogEntry(std::ostream &out, int level, const std::string &tags, const std::string &file, int line,
+                       const std::string &time, const std::string &message)
+{
+    std::stringstream prefix;
+    prefix << "[" << time << "] " << std::left << std::setw(15) << std::filesystem::path(file).stem().string();
+    if (line != -1)
+    {
+        prefix << " : " << std::right << std::setw(4) << line;
+    }
+    prefix << " [" << levelTag(level) << "] ";
+    std::string indent(prefix.str().size(), ' ');
+
+    out << prefix.str();
+    size_t start = 0;
+    bool first = true;
+    while (true)
+    {
+        size_t end = message.find('\n', start);
+        out << (first ? "" : indent) << message.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        first = false;
+        if (end == std::string::npos)
+            break;
+        out << "\n";
+        start = end + 1;
+    }
+    size_t tagsEnd = tags.find_last_not_of(' ');
+    if (tagsEnd != std::string::npos)
+        out << "  {" << tags.substr(0, tagsEnd + 1) << "}";
+    out << "\n";
+}
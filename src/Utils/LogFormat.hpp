@@ -0,0 +1,25 @@
+#ifndef LOGFORMAT_HPP
+#define LOGFORMAT_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// output layouts shared by Logger and the offline log converter
+// html matches what logs/logs.css and logs/logs.js expect
+
+extern const char *const kLogLevelTags[4];
+
+// "HH:MM:SS" local time for a wall clock timestamp in nanoseconds since epoch
+std::string formatLogTime(int64_t wallClockNs);
+
+void writeHtmlLogHeader(std::ostream &out, const std::string &title);
+void writeHtmlLogEntry(std::ostream &out, int level, const std::string &tags, const std::string &file, int line,
+                       const std::string &time, const std::string &message);
+void writeHtmlLogFooter(std::ostream &out);
+
+// plain text, one line per message line, continuation lines indented
+void writeTextLogEntry(std::ostream &out, int level, const std::string &tags, const std::string &file, int line,
+                       const std::string &time, const std::string &message);
+
+#endif // LOGFORMAT_HPP
@@ -0,0 +1,98 @@
+#ifndef LOGQUEUE_HPP
+#define LOGQUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// bounded multi-producer / single-consumer ring buffer used by the async logger
+// each slot carries a sequence number so producers only contend on one atomic
+// (Vyukov style) and never take a lock or allocate
+// capacity is rounded up to a power of two
+
+template <typename T>
+class LogQueue
+{
+public:
+    explicit LogQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        mask_ = size - 1;
+        slots_ = std::make_unique<Slot[]>(size);
+        for (size_t i = 0; i < size; ++i)
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        enqueuePos_.store(0, std::memory_order_relaxed);
+        dequeuePos_.store(0, std::memory_order_relaxed);
+    }
+
+    LogQueue(const LogQueue &) = delete;
+    LogQueue &operator=(const LogQueue &) = delete;
+
+    // returns false if the queue is full, item is left untouched in that case
+    bool tryPush(T &&item)
+    {
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        Slot *slot;
+        for (;;)
+        {
+            slot = &slots_[pos & mask_];
+            size_t seq = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = std::move(item);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // only ever called from the single consumer thread
+    bool tryPop(T &item)
+    {
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        Slot *slot = &slots_[pos & mask_];
+        size_t seq = slot->sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0)
+            return false;
+        dequeuePos_.store(pos + 1, std::memory_order_relaxed);
+        item = std::move(slot->value);
+        slot->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        size_t seq = slots_[pos & mask_].sequence.load(std::memory_order_acquire);
+        return static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> enqueuePos_;
+    alignas(64) std::atomic<size_t> dequeuePos_;
+};
+
+#endif // LOGQUEUE_HPP
@@ -0,0 +1,100 @@
+#ifndef LOGTAGS_HPP
+#define LOGTAGS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+// every tag a log call may use, each one owns a bit in a 64 bit mask
+// register new tags here, using an unlisted tag in logMessage is a compile error; names
+// only known at runtime (logMessageInternal callers) that are not listed carry no bit
+#define LOG_TAG_LIST(X) \
+    X(Graphics)         \
+    X(Vulkan)           \
+    X(OpenGL)           \
+    X(Metal)            \
+    X(OpenXR)           \
+    X(SDL)              \
+    X(Slang)            \
+    X(Material)         \
+    X(Model)            \
+    X(Initialization)   \
+    X(Selection)        \
+    X(Version)          \
+    X(Validation)       \
+    X(Error)            \
+    X(Warning)          \
+    X(Logger)
+
+enum class LogTag : uint8_t
+{
+#define LOG_TAG_ENUM(name) name,
+    LOG_TAG_LIST(LOG_TAG_ENUM)
+#undef LOG_TAG_ENUM
+    Count
+};
+
+inline constexpr const char *kLogTagNames[] = {
+#define LOG_TAG_NAME(name) #name,
+    LOG_TAG_LIST(LOG_TAG_NAME)
+#undef LOG_TAG_NAME
+};
+
+inline constexpr size_t kLogTagCount = static_cast<size_t>(LogTag::Count);
+static_assert(kLogTagCount <= 64, "log tags must fit in a 64 bit mask");
+
+inline constexpr uint64_t kAllLogTags = kLogTagCount == 64 ? ~0ull : ((1ull << kLogTagCount) - 1);
+
+constexpr bool logTagNameEquals(const char *a, const char *b)
+{
+    while (*a != '\0' && *a == *b)
+    {
+        ++a;
+        ++b;
+    }
+    return *a == *b;
+}
+
+// 0 for names missing from LOG_TAG_LIST
+constexpr uint64_t logTagBit(const char *name)
+{
+    for (size_t i = 0; i < kLogTagCount; ++i)
+    {
+        if (logTagNameEquals(kLogTagNames[i], name))
+            return 1ull << i;
+    }
+    return 0;
+}
+
+constexpr uint64_t logTagBit(LogTag tag)
+{
+    return 1ull << static_cast<unsigned>(tag);
+}
+
+// tag set carried by a log record, built from {"Graphics", "Vulkan"} style lists
+// the logMessage macro evaluates it at compile time so records never hold strings
+struct LogTags
+{
+    uint64_t mask = 0;
+    // a name was not in LOG_TAG_LIST, logMessage turns this into a compile error
+    bool unregistered = false;
+
+    constexpr LogTags() = default;
+    constexpr explicit LogTags(uint64_t bits) : mask(bits) {}
+    constexpr LogTags(std::initializer_list<const char *> names)
+    {
+        for (const char *name : names)
+        {
+            uint64_t bit = logTagBit(name);
+            unregistered = unregistered || bit == 0;
+            mask |= bit;
+        }
+    }
+    constexpr LogTags(std::initializer_list<LogTag> tags)
+    {
+        for (LogTag tag : tags)
+            mask |= logTagBit(tag);
+    }
+};
+
+#endif // LOGTAGS_HPP
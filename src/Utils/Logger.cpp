@@ -1,65 +1,278 @@
 #include "Logger.hpp"
 #include "Utils.hpp"
+#include "LogFormat.hpp"
 
-Logger *Logger::instance_ = nullptr;
+#include <algorithm>
+#include <cstring>
+
+std::atomic<Logger *> Logger::instance_{nullptr};
 std::mutex Logger::mutex_;
+std::atomic<int> Logger::logLevel_{LOG_COMPILE_LEVEL};
+std::atomic<uint64_t> Logger::tagFilter_{kAllLogTags};
+
+// ring buffer slots for async mode, overflowing records are dropped and counted
+static constexpr size_t kLogQueueCapacity = 8192;
+// writer thread idle poll interval
+static constexpr auto kWriterPollInterval = std::chrono::milliseconds(5);
+// log files are preallocated memory mapped segments, a full segment rotates to the next index
+static constexpr size_t kLogSegmentBytes = 4 * 1024 * 1024;
+// oldest logs are deleted once either limit is exceeded
+static constexpr size_t kLogMaxFiles = 32;
+static constexpr uint64_t kLogMaxTotalBytes = 256ull * 1024 * 1024;
+
+static uint64_t monotonicNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
-Logger::Logger() : logLevel_(CLI_LOGGING), logFileName_("")
+Logger::Logger() : logFileName_(""), logFileUsed_(0), binary_(BINARY_LOGGING), async_(ASYNC_LOGGING), stopWriter_(false), droppedRecords_(0), enqueuedRecords_(0), writtenRecords_(0), repeatCount_(0), lastRepeatNs_(0)
 {
-    if (logFileName_.empty())
+    // anchor pairing the monotonic record clock with the wall clock for printing times of day
+    monotonicStartNs_ = monotonicNowNs();
+    wallClockStartNs_ = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+    openSegment(0);
+    std::cout << "Logger initialized with log file: " << logFileName_ << (async_ ? " (async)" : "") << std::endl;
+
+    if (async_)
     {
-        genFileName();
+        queue_ = std::make_unique<LogQueue<LogRecord>>(kLogQueueCapacity);
+        writerThread_ = std::thread(&Logger::writerLoop, this);
     }
-    logFile_.open(logFileName_, std::ios::out | std::ios::app);
-    if (!logFile_.is_open())
+    atexit(disposeLogger);
+}
+
+Logger::~Logger()
+{
+    stopWriter();
+    flushRepeats(true);
+    closeSegment();
+}
+
+bool Logger::openSegment(size_t minimumBytes)
+{
+    genFileName();
+    size_t segmentBytes = std::max(kLogSegmentBytes, minimumBytes + 64 * 1024);
+    if (!logFile_.create(logFileName_, segmentBytes))
     {
         std::cerr << "Failed to open log file: " << logFileName_ << std::endl;
+        return false;
+    }
+    logFileUsed_ = 0;
+
+    // every segment starts with its own header so it can be read on its own
+    fileBuffer_.clear();
+    if (binary_)
+    {
+        uint64_t now = monotonicNowNs();
+        binaryEncoder_.begin(fileBuffer_, wallClockStartNs_ + static_cast<int64_t>(now - monotonicStartNs_), now, kLogTagNames, kLogTagCount);
     }
     else
     {
-        logFile_ << "<html><head><title>Log File</title><link rel=\"stylesheet\" href=\"logs.css\"><script src=\"logs.js\"></script></head><body>" << std::endl;
-        logFile_ << "<h1>Log " << logFileName_ << "</h1>" << std::endl;
+        std::ostringstream header;
+        writeHtmlLogHeader(header, logFileName_);
+        fileBuffer_ = header.str();
     }
-    std::cout << "Logger initialized with log file: " << logFileName_ << std::endl;
-    atexit(disposeLogger);
+    std::memcpy(logFile_.data(), fileBuffer_.data(), fileBuffer_.size());
+    logFileUsed_ = fileBuffer_.size();
+
+    pruneLogs();
+    return true;
 }
 
-Logger::~Logger()
+void Logger::closeSegment()
+{
+    if (!logFile_.isOpen())
+        return;
+
+    fileBuffer_.clear();
+    if (binary_)
+    {
+        fileBuffer_.push_back(static_cast<char>(BinaryLogChunk::End));
+    }
+    else
+    {
+        std::ostringstream footer;
+        writeHtmlLogFooter(footer);
+        fileBuffer_ = footer.str();
+    }
+    size_t footerBytes = std::min(fileBuffer_.size(), logFile_.size() - logFileUsed_);
+    std::memcpy(logFile_.data() + logFileUsed_, fileBuffer_.data(), footerBytes);
+
+    // drop the unused preallocated tail
+    logFile_.close(logFileUsed_ + footerBytes);
+}
+
+bool Logger::segmentHasRoom(size_t bytes) const
+{
+    // keep room for the footer
+    return logFileUsed_ + bytes + 16 <= logFile_.size();
+}
+
+bool Logger::rotateSegment(size_t minimumBytes)
+{
+    closeSegment();
+    return openSegment(minimumBytes);
+}
+
+void Logger::appendToFile(const std::string &bytes)
+{
+    if (!logFile_.isOpen() || !segmentHasRoom(bytes.size()))
+        return;
+    std::memcpy(logFile_.data() + logFileUsed_, bytes.data(), bytes.size());
+    logFileUsed_ += bytes.size();
+}
+
+void Logger::pruneLogs()
 {
-    if (logFile_.is_open())
+    try
+    {
+        std::filesystem::path logDir = std::filesystem::path(logFileName_).parent_path();
+        if (logDir.empty())
+            return;
+        const std::string extension = binary_ ? ".vrlog" : ".html";
+
+        std::vector<std::pair<int, std::filesystem::path>> logs;
+        for (const auto &entry : std::filesystem::directory_iterator(logDir))
+        {
+            if (!entry.is_regular_file() || entry.path().extension() != extension)
+                continue;
+            try
+            {
+                logs.emplace_back(std::stoi(entry.path().filename().stem().string()), entry.path());
+            }
+            catch (const std::exception &e)
+            {
+                continue;
+            }
+        }
+        std::sort(logs.begin(), logs.end());
+
+        uint64_t totalBytes = 0;
+        for (const auto &log : logs)
+            totalBytes += std::filesystem::file_size(log.second);
+
+        // newest file is the one being written, never remove it
+        for (size_t i = 0; i + 1 < logs.size(); ++i)
+        {
+            if (logs.size() - i <= kLogMaxFiles && totalBytes <= kLogMaxTotalBytes)
+                break;
+            totalBytes -= std::filesystem::file_size(logs[i].second);
+            std::filesystem::remove(logs[i].second);
+        }
+    }
+    catch (const std::exception &e)
     {
-        logFile_ << "</body></html>" << std::endl;
-        logFile_.flush();
-        logFile_.close();
+        std::cerr << "Exception while pruning old logs: " << e.what() << std::endl;
     }
 }
 
 Logger *Logger::getInstance()
 {
+    Logger *instance = instance_.load(std::memory_order_acquire);
+    if (instance != nullptr)
+    {
+        return instance;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
-    if (instance_ == nullptr)
+    instance = instance_.load(std::memory_order_relaxed);
+    if (instance == nullptr)
     {
-        instance_ = new Logger();
+        instance = new Logger();
+        instance_.store(instance, std::memory_order_release);
     }
-    return instance_;
+    return instance;
 }
 
-void Logger::logMessageInternal(int level, const std::string &message, const std::vector<std::string> &tags, const char *file, int line)
+void Logger::logMessageInternal(int level, std::string message, LogTags tags, const char *file, int line)
 {
-    level = std::max(1, std::min(level, static_cast<int>(levelTags_.size()))); // clamp level between 1 and max
-    // Get current time
-    auto now = std::chrono::system_clock::now();
-    auto in_time_t = std::chrono::system_clock::to_time_t(now);
-    std::stringstream timeStream;
-    timeStream << std::put_time(std::localtime(&in_time_t), "%X");
+    LogRecord record;
+    record.level = clampLogLevel(level);
+    record.line = line;
+    record.file = file;
+    record.timeNs = monotonicNowNs();
+    record.tagMask = tags.mask;
+    record.message = std::move(message);
+
+    if (async_)
+    {
+        int recordLevel = record.level;
+        if (!queue_->tryPush(std::move(record)))
+        {
+            droppedRecords_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        enqueuedRecords_.fetch_add(1, std::memory_order_release);
+        if (recordLevel == 1)
+        {
+            // errors are pushed out immediately instead of waiting for the next poll
+            writerWake_.notify_one();
+        }
+        return;
+    }
 
-    std::string filename = std::filesystem::path(file).stem().string();
+    // a run whose window has passed is summarized by writeRecord before this record
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    writeRecord(record, true);
+}
+
+void Logger::writeRecord(const LogRecord &record, bool flush)
+{
+    // only collapse within a window of the last occurrence, a message that comes back
+    // after a quiet period is written again
+    uint64_t lastSeenNs = repeatCount_ != 0 ? lastRepeatNs_ : lastRecord_.timeNs;
+    if (record.timeNs - lastSeenNs < kLogSiteWindowNs && record.file == lastRecord_.file && record.line == lastRecord_.line &&
+        record.level == lastRecord_.level && record.tagMask == lastRecord_.tagMask && record.message == lastRecord_.message)
+    {
+        ++repeatCount_;
+        lastRepeatNs_ = record.timeNs;
+        return;
+    }
+    flushRepeats(false);
+    lastRecord_ = record;
+    emitRecord(record, flush);
+}
+
+void Logger::flushRepeats(bool flush)
+{
+    if (repeatCount_ == 0)
+        return;
+    LogRecord summary;
+    summary.level = lastRecord_.level;
+    summary.line = lastRecord_.line;
+    summary.file = lastRecord_.file;
+    summary.tagMask = lastRecord_.tagMask;
+    summary.timeNs = lastRepeatNs_;
+    summary.message = "message repeated " + std::to_string(repeatCount_) + " times in " +
+                      std::to_string((lastRepeatNs_ - lastRecord_.timeNs) / 1000000) + " ms";
+    repeatCount_ = 0;
+    emitRecord(summary, flush);
+}
+
+bool Logger::flushExpiredRepeats(uint64_t now, bool flush)
+{
+    if (repeatCount_ == 0 || now - lastRepeatNs_ < kLogSiteWindowNs)
+        return false;
+    flushRepeats(flush);
+    return true;
+}
+
+void Logger::emitRecord(const LogRecord &record, bool flush)
+{
+    int level = record.level;
+    const std::string &message = record.message;
+    int line = record.line;
+
+    // Get record time
+    std::string time = formatLogTime(wallClockStartNs_ + static_cast<int64_t>(record.timeNs - monotonicStartNs_));
 
     if (CLI_LOGGING >= level)
     {
+        std::string filename = std::filesystem::path(record.file).stem().string();
+
         // Format message
         std::stringstream formattedMessage;
-        formattedMessage << "\033[90m" << "[" << timeStream.str() << "] ";
+        formattedMessage << "\033[90m" << "[" << time << "] ";
         formattedMessage << "\033[95m" << std::left << std::setw(15) << filename;
         if (line != -1)
         {
@@ -82,48 +295,145 @@ void Logger::logMessageInternal(int level, const std::string &message, const std
                 std::string line = tmpMsg.substr(0, pos);
                 if (!first)
                     line = "                                     " + line;
-                std::cout << line << std::endl;
+                std::cout << line << '\n';
                 tmpMsg = tmpMsg.substr(pos + 1);
                 first = false;
             }
             else
             {
-                std::cout << (first ? "" : "                                     ") << tmpMsg << std::endl;
+                std::cout << (first ? "" : "                                     ") << tmpMsg << '\n';
                 break;
             }
         }
 
         // reset CLI color
         std::cout << "\033[0m";
+        if (flush)
+            std::cout.flush();
+    }
+
+    // Log to file, writes land in the mapped segment so no per line flush is needed
+    if (logFile_.isOpen())
+    {
+        if (binary_)
+        {
+            fileBuffer_.clear();
+            binaryEncoder_.appendEntry(fileBuffer_, record.timeNs, level, record.file, line, record.tagMask, message);
+            if (!segmentHasRoom(fileBuffer_.size()))
+            {
+                // a new segment restarts the string table, so encode the entry again against it
+                if (rotateSegment(fileBuffer_.size()))
+                {
+                    fileBuffer_.clear();
+                    binaryEncoder_.appendEntry(fileBuffer_, record.timeNs, level, record.file, line, record.tagMask, message);
+                }
+            }
+            appendToFile(fileBuffer_);
+        }
+        else
+        {
+            std::string tags;
+            for (size_t i = 0; i < kLogTagCount; ++i)
+            {
+                if (record.tagMask & (1ull << i))
+                {
+                    tags += kLogTagNames[i];
+                    tags += ' ';
+                }
+            }
+            std::ostringstream entry;
+            writeHtmlLogEntry(entry, level, tags, record.file, line, time, message);
+            fileBuffer_ = entry.str();
+            if (!segmentHasRoom(fileBuffer_.size()))
+                rotateSegment(fileBuffer_.size());
+            appendToFile(fileBuffer_);
+        }
     }
+}
 
-    // Log to file
-    if (logFile_.is_open())
+void Logger::writerLoop()
+{
+    LogRecord record;
+    uint64_t lastSiteSweepNs = monotonicNowNs();
+    for (;;)
     {
-        std::string htmlMessage = message;
-        size_t pos = 0;
-        while ((pos = htmlMessage.find('\n', pos)) != std::string::npos)
+        bool wrote = false;
+        uint64_t popped = 0;
+        while (queue_->tryPop(record))
         {
-            htmlMessage.replace(pos, 1, "<br>");
-            pos += 4; // length of <br>
+            writeRecord(record, false);
+            wrote = true;
+            ++popped;
         }
 
-        logFile_ << "<div class=\"log-entry level-" << level << "\" data-tags=\"";
-        for (const auto &tag : tags)
+        uint64_t dropped = droppedRecords_.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0)
         {
-            logFile_ << tag << " ";
+            LogRecord overflow;
+            overflow.level = 2;
+            overflow.file = __FILE__;
+            overflow.line = __LINE__;
+            overflow.timeNs = monotonicNowNs();
+            overflow.message = "Log queue full, dropped " + std::to_string(dropped) + " records";
+            overflow.tagMask = logTagBit(LogTag::Logger);
+            writeRecord(overflow, false);
+            wrote = true;
         }
-        logFile_ << "\"";
-        logFile_ << " data-file=\"" << file << "\"";
-        if (line != -1)
+
+        // close out repeat runs and throttled call sites that have gone quiet
+        uint64_t now = monotonicNowNs();
+        if (flushExpiredRepeats(now, false))
+            wrote = true;
+        if (now - lastSiteSweepNs >= kLogSiteWindowNs)
+        {
+            LogCallSite::flushSuppressed(false);
+            // the mapping already survives a crash of this process, this bounds what an os crash can lose
+            logFile_.flushAsync();
+            lastSiteSweepNs = now;
+        }
+
+        // flush once per batch instead of once per line
+        if (wrote)
         {
-            logFile_ << " data-line=\"" << line << "\"";
+            std::cout.flush();
+            writtenRecords_.fetch_add(popped, std::memory_order_release);
+            writerWake_.notify_all();
         }
-        logFile_ << ">";
-        logFile_ << "<div class=\"time\">[" << timeStream.str() << "]</div> ";
-        logFile_ << "<div class=\"level-tag\">[" << levelTags_[level - 1] << "]</div> ";
-        logFile_ << "<div class=\"message\">" << htmlMessage << "</div>";
-        logFile_ << "</div>" << std::endl;
+
+        if (stopWriter_.load(std::memory_order_acquire) && queue_->empty())
+            break;
+
+        std::unique_lock<std::mutex> lock(writerMutex_);
+        writerWake_.wait_for(lock, kWriterPollInterval);
+    }
+}
+
+void Logger::stopWriter()
+{
+    if (!writerThread_.joinable())
+        return;
+    stopWriter_.store(true, std::memory_order_release);
+    writerWake_.notify_all();
+    writerThread_.join();
+}
+
+void Logger::flush()
+{
+    if (!async_)
+    {
+        // sync mode writes everything immediately, only a quiet repeat run can be pending
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        flushExpiredRepeats(monotonicNowNs(), true);
+        return;
+    }
+    if (!writerThread_.joinable())
+        return;
+    uint64_t target = enqueuedRecords_.load(std::memory_order_acquire);
+    writerWake_.notify_all();
+    std::unique_lock<std::mutex> lock(writerMutex_);
+    while (writtenRecords_.load(std::memory_order_acquire) < target)
+    {
+        writerWake_.wait_for(lock, kWriterPollInterval);
     }
 }
 
@@ -161,22 +471,24 @@ void Logger::genFileName()
 
         std::stringstream ss;
         ss << std::setw(4) << std::setfill('0') << (logIndex + 1);
-        this->logFileName_ = logDir + "/" + ss.str() + "_log_" + datestream.str() + ".html";
+        this->logFileName_ = logDir + "/" + ss.str() + "_log_" + datestream.str() + (binary_ ? ".vrlog" : ".html");
     }
     catch (const std::exception &e)
     {
         std::cerr << "Exception while creating logs directory: " << e.what() << std::endl;
-        this->logFileName_ = "log.html";
+        this->logFileName_ = binary_ ? "log.vrlog" : "log.html";
         return;
     }
 }
 
 void Logger::dispose()
 {
+    // report calls still held back by rate limited call sites before shutting down
+    LogCallSite::flushSuppressed(true);
     std::lock_guard<std::mutex> lock(mutex_);
-    if (instance_ != nullptr)
+    Logger *instance = instance_.exchange(nullptr, std::memory_order_acq_rel);
+    if (instance != nullptr)
     {
-        delete instance_;
-        instance_ = nullptr;
+        delete instance;
     }
 }
@@ -11,30 +11,117 @@
 #include <filesystem>
 #include <cstdlib>
 #include <sstream>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <memory>
+
+#include "LogQueue.hpp"
+#include "LogTags.hpp"
+#include "BinaryLog.hpp"
+#include "LogCallSite.hpp"
+#include "MappedFile.hpp"
 
 // forward declaration of the C-style API exported from Utils
 void disposeLogger();
 
+// levels outside 1 (errors) to 4 (detailed info) are clamped into range
+constexpr int clampLogLevel(int level)
+{
+    return level < 1 ? 1 : (level > 4 ? 4 : level);
+}
+
+// compact record handed from the calling thread to the writer
+// file points at a __FILE__ literal so it never needs copying
+struct LogRecord
+{
+    int level = 0;
+    int line = -1;
+    const char *file = "";
+    uint64_t timeNs = 0; // steady clock, nanoseconds
+    uint64_t tagMask = 0;
+    std::string message;
+};
+
 class Logger {
 private:
-    static Logger* instance_;
+    static std::atomic<Logger*> instance_;
     static std::mutex mutex_;
-    int logLevel_;
+    static std::atomic<int> logLevel_;
+    static std::atomic<uint64_t> tagFilter_;
     std::string logFileName_;
-    std::ofstream logFile_;
+    // current memory mapped segment, rotated by size and pruned by count / total bytes
+    MappedFile logFile_;
+    size_t logFileUsed_;
+    std::string fileBuffer_;
+    int64_t wallClockStartNs_;
+    uint64_t monotonicStartNs_;
+
+    // BINARY_LOGGING writes .vrlog files instead of html, see BinaryLog.hpp
+    bool binary_;
+    BinaryLogEncoder binaryEncoder_;
     const std::vector<std::string> levelTags_ = {"ERR ", "WARN", "STEP", "INFO"};
     const std::vector<std::string> levelColors_ = {"#880000", "#888800", "#008800", "#000088"};
     const std::vector<std::string> levelConsoleColors_ = {"\033[1;31m", "\033[1;33m", "\033[1;32m", "\033[1;34m"};
     const std::vector<std::string> levelConsoleColorsDim_ = {"\033[2:31m", "\033[2:33m", "\033[2:32m", "\033[2:34m"};
 
+    // async mode, callers push into queue_ and writerThread_ does all formatting and I/O
+    bool async_;
+    std::unique_ptr<LogQueue<LogRecord>> queue_;
+    std::thread writerThread_;
+    std::atomic<bool> stopWriter_;
+    std::atomic<uint64_t> droppedRecords_;
+    // records pushed and records written (and flushed to the console) so far, flush()
+    // waits for the second to reach the first instead of for an empty queue, which the
+    // writer empties before it has written what it popped
+    std::atomic<uint64_t> enqueuedRecords_;
+    std::atomic<uint64_t> writtenRecords_;
+    std::mutex writerMutex_;
+    std::condition_variable writerWake_;
+
+    // serializes formatting in sync mode so worker threads can log safely
+    std::mutex writeMutex_;
+
+    // consecutive identical records are collapsed into one summary line
+    LogRecord lastRecord_;
+    uint32_t repeatCount_;
+    uint64_t lastRepeatNs_;
+
     void genFileName();
+    bool openSegment(size_t minimumBytes);
+    void closeSegment();
+    bool rotateSegment(size_t minimumBytes);
+    bool segmentHasRoom(size_t bytes) const;
+    void appendToFile(const std::string &bytes);
+    void pruneLogs();
+    void writeRecord(const LogRecord &record, bool flush);
+    void emitRecord(const LogRecord &record, bool flush);
+    void flushRepeats(bool flush);
+    bool flushExpiredRepeats(uint64_t now, bool flush);
+    void writerLoop();
+    void stopWriter();
 
     Logger();
     ~Logger();
 
 public:
     static Logger* getInstance();
-    void logMessageInternal(int level, const std::string &message, const std::vector<std::string> &tags = {}, const char* file = "", int line = -1);
+
+    // runtime level threshold, checked before the message is built
+    static bool levelEnabled(int level) { return clampLogLevel(level) <= logLevel_.load(std::memory_order_relaxed); }
+    static void setLogLevel(int level) { logLevel_.store(level, std::memory_order_relaxed); }
+
+    // runtime tag filter, a record is dropped if it carries any disabled tag
+    // errors (level 1) always pass so muting a subsystem never hides a failure
+    static bool tagsEnabled(int level, uint64_t tagMask) { return level <= 1 || (tagMask & ~tagFilter_.load(std::memory_order_relaxed)) == 0; }
+    static void setTagFilter(uint64_t enabledTags) { tagFilter_.store(enabledTags, std::memory_order_relaxed); }
+    static void enableTags(LogTags tags) { tagFilter_.fetch_or(tags.mask, std::memory_order_relaxed); }
+    static void disableTags(LogTags tags) { tagFilter_.fetch_and(~tags.mask, std::memory_order_relaxed); }
+
+    void logMessageInternal(int level, std::string message, LogTags tags = {}, const char* file = "", int line = -1);
+    // blocks until every queued record has been written, and writes out repeat
+    // summaries whose window has passed
+    void flush();
     void dispose();
 };
 
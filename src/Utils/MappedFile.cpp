@@ -0,0 +1,256 @@
+#include "MappedFile.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        data_ = other.data_;
+        size_ = other.size_;
+        writable_ = other.writable_;
+        path_ = std::move(other.path_);
+#ifdef _WIN32
+        fileHandle_ = other.fileHandle_;
+        mappingHandle_ = other.mappingHandle_;
+#else
+        fd_ = other.fd_;
+#endif
+        other.reset();
+    }
+    return *this;
+}
+
+void MappedFile::reset()
+{
+    data_ = nullptr;
+    size_ = 0;
+    writable_ = false;
+    path_.clear();
+#ifdef _WIN32
+    fileHandle_ = nullptr;
+    mappingHandle_ = nullptr;
+#else
+    fd_ = -1;
+#endif
+}
+
+#ifdef _WIN32
+
+bool MappedFile::openRead(const std::string &path)
+{
+    close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle_ = file;
+    mappingHandle_ = mapping;
+    data_ = static_cast<uint8_t *>(view);
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+    writable_ = false;
+    path_ = path;
+    return true;
+}
+
+bool MappedFile::create(const std::string &path, size_t size)
+{
+    close();
+    if (size == 0)
+        return false;
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                              CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    // mapping a region larger than the file extends the file to that size
+    ULARGE_INTEGER mappingSize;
+    mappingSize.QuadPart = size;
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, mappingSize.HighPart, mappingSize.LowPart, nullptr);
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (view == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle_ = file;
+    mappingHandle_ = mapping;
+    data_ = static_cast<uint8_t *>(view);
+    size_ = size;
+    writable_ = true;
+    path_ = path;
+    return true;
+}
+
+void MappedFile::close(size_t truncateSize)
+{
+    if (data_ != nullptr)
+        UnmapViewOfFile(data_);
+    if (mappingHandle_ != nullptr)
+        CloseHandle(mappingHandle_);
+    if (fileHandle_ != nullptr)
+    {
+        if (writable_ && truncateSize < size_)
+        {
+            LARGE_INTEGER end;
+            end.QuadPart = static_cast<LONGLONG>(truncateSize);
+            if (SetFilePointerEx(fileHandle_, end, nullptr, FILE_BEGIN))
+                SetEndOfFile(fileHandle_);
+        }
+        CloseHandle(fileHandle_);
+    }
+    reset();
+}
+
+void MappedFile::flushAsync()
+{
+    // FlushViewOfFile starts the write back and returns without waiting for the disk
+    if (data_ != nullptr && writable_)
+        FlushViewOfFile(data_, 0);
+}
+
+#else
+
+bool MappedFile::openRead(const std::string &path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void *view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    fd_ = fd;
+    data_ = static_cast<uint8_t *>(view);
+    size_ = static_cast<size_t>(st.st_size);
+    writable_ = false;
+    path_ = path;
+    return true;
+}
+
+bool MappedFile::create(const std::string &path, size_t size)
+{
+    close();
+    if (size == 0)
+        return false;
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void *view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    fd_ = fd;
+    data_ = static_cast<uint8_t *>(view);
+    size_ = size;
+    writable_ = true;
+    path_ = path;
+    return true;
+}
+
+void MappedFile::close(size_t truncateSize)
+{
+    if (data_ != nullptr)
+        munmap(data_, size_);
+    if (fd_ >= 0)
+    {
+        if (writable_ && truncateSize < size_)
+        {
+            if (ftruncate(fd_, static_cast<off_t>(truncateSize)) != 0)
+            {
+                // leaves the zero filled tail in place, readers stop at the first zero chunk
+            }
+        }
+        ::close(fd_);
+    }
+    reset();
+}
+
+void MappedFile::flushAsync()
+{
+    if (data_ != nullptr && writable_)
+        msync(data_, size_, MS_ASYNC);
+}
+
+#endif
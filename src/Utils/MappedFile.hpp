@@ -0,0 +1,56 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// memory mapped file, read only views for loading assets and
+// preallocated writable views for log segments
+// wraps mmap on posix and CreateFileMapping / MapViewOfFile on windows
+
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    // maps an existing file read only, empty files fail to map
+    bool openRead(const std::string &path);
+    // creates or truncates path, preallocates size bytes (zero filled) and maps it writable
+    bool create(const std::string &path, size_t size);
+    // unmaps, writable files are cut down to truncateSize bytes when it is smaller than the mapping
+    void close(size_t truncateSize = SIZE_MAX);
+
+    // schedules dirty pages for write back without waiting, data already survives a
+    // process crash once written to the mapping, this only narrows the window for an os crash
+    void flushAsync();
+
+    bool isOpen() const { return data_ != nullptr; }
+    uint8_t *data() { return data_; }
+    const uint8_t *data() const { return data_; }
+    size_t size() const { return size_; }
+    const std::string &path() const { return path_; }
+
+private:
+    uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+    bool writable_ = false;
+    std::string path_;
+
+#ifdef _WIN32
+    void *fileHandle_ = nullptr;
+    void *mappingHandle_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+
+    void reset();
+};
+
+#endif // MAPPEDFILE_HPP
@@ -0,0 +1,117 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        unsigned int hardware = std::thread::hardware_concurrency();
+        threadCount = hardware > 1 ? hardware - 1 : 1;
+    }
+    workers_.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i)
+        workers_.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread &worker : workers_)
+    {
+        if (worker.joinable())
+            worker.join();
+    }
+}
+
+ThreadPool &ThreadPool::shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    wake_.notify_one();
+}
+
+void ThreadPool::workerLoop()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            // queued work still runs on shutdown so no future is left without a value
+            if (tasks_.empty())
+                return;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+namespace
+{
+    // shared between the caller and the helpers of one parallelFor, helpers that only
+    // get scheduled after the caller returned find no items left and exit
+    struct ParallelForState
+    {
+        std::function<void(size_t)> body;
+        size_t count = 0;
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> finished{0};
+        std::mutex mutex;
+        std::condition_variable done;
+
+        void run()
+        {
+            size_t ran = 0;
+            for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < count; i = next.fetch_add(1, std::memory_order_relaxed))
+            {
+                body(i);
+                ++ran;
+            }
+            if (ran != 0 && finished.fetch_add(ran, std::memory_order_acq_rel) + ran == count)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done.notify_all();
+            }
+        }
+    };
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> &body)
+{
+    if (count == 0)
+        return;
+    if (count == 1 || workers_.empty())
+    {
+        for (size_t i = 0; i < count; ++i)
+            body(i);
+        return;
+    }
+
+    auto state = std::make_shared<ParallelForState>();
+    state->body = body;
+    state->count = count;
+
+    size_t helpers = std::min(count - 1, workers_.size());
+    for (size_t i = 0; i < helpers; ++i)
+        enqueue([state]() { state->run(); });
+
+    state->run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&state]() { return state->finished.load(std::memory_order_acquire) == state->count; });
+}
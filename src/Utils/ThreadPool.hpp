@@ -0,0 +1,60 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// fixed size worker pool for loading work (meshes, shaders)
+// ThreadPool::shared() is sized to the machine and lives until exit
+// parallelFor has the calling thread take items too, so it is safe to call
+// from inside a pool task without starving the pool
+
+class ThreadPool
+{
+public:
+    // 0 picks hardware_concurrency - 1 (at least one worker)
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    static ThreadPool &shared();
+
+    size_t threadCount() const { return workers_.size(); }
+
+    template <typename F>
+    auto submit(F &&task) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+    {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> future = packaged->get_future();
+        enqueue([packaged]() { (*packaged)(); });
+        return future;
+    }
+
+    // runs body(i) for every i in [0, count) and returns once all of them finished
+    // items are handed out one at a time, so uneven items still balance
+    void parallelFor(size_t count, const std::function<void(size_t)> &body);
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+
+    void enqueue(std::function<void()> task);
+    void workerLoop();
+};
+
+#endif // THREADPOOL_HPP
@@ -6,10 +6,10 @@ void disposeLogger()
     Logger::getInstance()->dispose();
 }
 
-void logMessageInternal(int level, const std::string &message, const std::vector<std::string> &tags, const char* file, int line)
+void logMessageInternal(int level, std::string message, LogTags tags, const char* file, int line)
 {
     if (CLI_LOGGING == 0)
         return;
     
-    Logger::getInstance()->logMessageInternal(level, message, tags, file, line);
+    Logger::getInstance()->logMessageInternal(level, std::move(message), tags, file, line);
 }
\ No newline at end of file
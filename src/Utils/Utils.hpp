@@ -9,12 +9,47 @@
 #include <iomanip>
 #include <filesystem>
 #include <cstdlib>
+#include <sstream>
 
 #include "Logger.hpp"
 
-#define logMessage(...) logMessageInternal(__VA_ARGS__, __FILE__, __LINE__)
+// levels above LOG_COMPILE_LEVEL are discarded at compile time, the message
+// expression is only evaluated once the level has passed both the compile time
+// and the runtime (Logger::setLogLevel) threshold, so filtered calls cost nothing
+// tags are resolved to a bit mask at compile time and checked against the
+// runtime tag filter (Logger::disableTags) before any formatting
+// each call site is rate limited (LogCallSite), spam is summarized instead of written
+#define logMessage(level, message, ...)                                                              \
+    do                                                                                               \
+    {                                                                                                \
+        if constexpr (logLevelCompiled(level))                                                       \
+        {                                                                                            \
+            constexpr LogTags logMessageTags_{__VA_ARGS__};                                          \
+            static_assert(!logMessageTags_.unregistered, "log tag missing from LOG_TAG_LIST");       \
+            static LogCallSite logMessageSite_;                                                      \
+            if (Logger::levelEnabled(level) && Logger::tagsEnabled(level, logMessageTags_.mask) &&   \
+                logMessageSite_.admit(level, logMessageTags_.mask, __FILE__, __LINE__))              \
+                logMessageInternal(level, message, logMessageTags_, __FILE__, __LINE__);             \
+        }                                                                                            \
+    } while (0)
 
-void logMessageInternal(int level, const std::string &message, const std::vector<std::string> &tags = {}, const char* file = "", int line = -1);
+constexpr bool logLevelCompiled(int level)
+{
+    return CLI_LOGGING != 0 && clampLogLevel(level) <= LOG_COMPILE_LEVEL;
+}
+
+// streams all arguments into one string, use inside logMessage so the
+// formatting only happens when the record is emitted
+// logMessage(4, logFormat("Loaded ", count, " meshes"), {"Graphics"});
+template <typename... Args>
+std::string logFormat(const Args &...args)
+{
+    std::ostringstream ss;
+    (ss << ... << args);
+    return ss.str();
+}
+
+void logMessageInternal(int level, std::string message, LogTags tags = {}, const char* file = "", int line = -1);
 // writes to console with color and saves to html file
 // higher numbers are more granlular
 // prints up to and including the set level
@@ -24,6 +59,7 @@ void logMessageInternal(int level, const std::string &message, const std::vector
 // 2 - warnings
 // 3 - step titles
 // 4 - detailed info
+// with ASYNC_LOGGING the call only queues the record, a background thread writes it
 
 void disposeLogger();
 
@@ -0,0 +1,93 @@
+// VRLogConvert - renders a binary .vrlog file written by Logger (BINARY_LOGGING)
+// into the html layout used by logs/logs.css + logs/logs.js, or into plain text
+//
+// usage: VRLogConvert <input.vrlog> [output] [--text]
+// logs from a crashed run still convert, output stops at the last complete record
+// output defaults to the input path with a .html (or .txt) extension, so logs
+// converted in place pick up the viewer files that live next to them in logs/
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "Utils/BinaryLog.hpp"
+#include "Utils/LogFormat.hpp"
+#include "Utils/MappedFile.hpp"
+
+int main(int argc, char **argv)
+{
+    std::string inputPath;
+    std::string outputPath;
+    bool text = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--text" || arg == "-t")
+            text = true;
+        else if (inputPath.empty())
+            inputPath = arg;
+        else if (outputPath.empty())
+            outputPath = arg;
+    }
+
+    if (inputPath.empty())
+    {
+        std::cerr << "usage: VRLogConvert <input.vrlog> [output] [--text]" << std::endl;
+        return 1;
+    }
+    if (outputPath.empty())
+    {
+        outputPath = std::filesystem::path(inputPath).replace_extension(text ? ".txt" : ".html").string();
+    }
+
+    MappedFile input;
+    if (!input.openRead(inputPath))
+    {
+        std::cerr << "Failed to open log file: " << inputPath << std::endl;
+        return 1;
+    }
+
+    BinaryLogDecoder decoder(input.data(), input.size());
+    if (!decoder.valid())
+    {
+        std::cerr << "Not a binary log file (bad header or version): " << inputPath << std::endl;
+        return 1;
+    }
+
+    std::ofstream output(outputPath, std::ios::out | std::ios::trunc);
+    if (!output.is_open())
+    {
+        std::cerr << "Failed to open output file: " << outputPath << std::endl;
+        return 1;
+    }
+
+    if (!text)
+        writeHtmlLogHeader(output, std::filesystem::path(inputPath).generic_string());
+
+    size_t entryCount = 0;
+    BinaryLogEntry entry;
+    while (decoder.next(entry))
+    {
+        std::string time = formatLogTime(decoder.wallClockNs(entry.timeNs));
+        std::string tags = decoder.tagNames(entry.tagMask);
+        std::string file(entry.file);
+        std::string message(entry.message);
+        if (text)
+            writeTextLogEntry(output, entry.level, tags, file, entry.line, time, message);
+        else
+            writeHtmlLogEntry(output, entry.level, tags, file, entry.line, time, message);
+        ++entryCount;
+    }
+
+    if (!text)
+        writeHtmlLogFooter(output);
+
+    std::cout << "Converted " << entryCount << " entries to " << outputPath << std::endl;
+    if (decoder.truncated())
+    {
+        std::cerr << "Warning: log ends with a damaged or incomplete record, output stops there" << std::endl;
+    }
+    return 0;
+}
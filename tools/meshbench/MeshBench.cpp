@@ -0,0 +1,180 @@
+// VRMeshBench - times vertex welding with VertexWeldTable against the node based
+// std::unordered_map<Vertex> it replaced, on an OBJ file and a synthetic grid
+//
+// usage: VRMeshBench [model.obj] [gridSize]
+// model defaults to assets/suzanne.obj, gridSize (default 1200) builds a grid of
+// gridSize x gridSize quads, 1200 gives 2.88M triangles
+// both welds must produce the same vertex and index arrays, the tool fails otherwise
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <tiny_obj_loader.h>
+
+#include "Graphics/Objects/Model.hpp"
+#include "Graphics/Objects/VertexWeld.hpp"
+
+namespace
+{
+    // the per float hash Model used before VertexWeldTable
+    struct LegacyVertexHash
+    {
+        size_t operator()(const Vertex &v) const noexcept
+        {
+            auto h = size_t{0};
+            auto mix = [](size_t seed, size_t v) noexcept
+            {
+                seed ^= v + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+                return seed;
+            };
+            const float *values = &v.position.x;
+            for (int i = 0; i < 11; ++i)
+                h = mix(h, std::hash<float>{}(values[i]));
+            return h;
+        }
+    };
+
+    struct WeldResult
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+    };
+
+    WeldResult weldUnorderedMap(const std::vector<Vertex> &corners)
+    {
+        WeldResult result;
+        std::unordered_map<Vertex, uint32_t, LegacyVertexHash> uniqueVertices;
+        for (const Vertex &vertex : corners)
+        {
+            if (uniqueVertices.count(vertex) == 0)
+            {
+                uniqueVertices[vertex] = static_cast<uint32_t>(result.vertices.size());
+                result.vertices.push_back(vertex);
+            }
+            result.indices.push_back(uniqueVertices[vertex]);
+        }
+        return result;
+    }
+
+    WeldResult weldTable(const std::vector<Vertex> &corners)
+    {
+        WeldResult result;
+        result.indices.reserve(corners.size());
+        VertexWeldTable<Vertex> uniqueVertices(result.vertices, corners.size() / 4);
+        for (const Vertex &vertex : corners)
+            result.indices.push_back(uniqueVertices.weld(vertex));
+        return result;
+    }
+
+    bool loadCorners(const std::string &path, std::vector<Vertex> &corners)
+    {
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string warn, err;
+        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str()))
+            return false;
+        for (const auto &shape : shapes)
+        {
+            for (const auto &index : shape.mesh.indices)
+            {
+                Vertex vertex{};
+                vertex.position = {attrib.vertices[3 * index.vertex_index + 0], attrib.vertices[3 * index.vertex_index + 1],
+                                   attrib.vertices[3 * index.vertex_index + 2]};
+                if (index.normal_index >= 0)
+                    vertex.normal = {attrib.normals[3 * index.normal_index + 0], attrib.normals[3 * index.normal_index + 1],
+                                     attrib.normals[3 * index.normal_index + 2]};
+                if (index.texcoord_index >= 0)
+                    vertex.texCoord = {attrib.texcoords[2 * index.texcoord_index + 0], attrib.texcoords[2 * index.texcoord_index + 1]};
+                vertex.color = glm::vec3(1.0f, 1.0f, 1.0f);
+                corners.push_back(vertex);
+            }
+        }
+        return true;
+    }
+
+    // height field grid, every interior vertex is shared by six triangle corners
+    std::vector<Vertex> gridCorners(int size)
+    {
+        auto gridVertex = [size](int x, int y)
+        {
+            Vertex vertex{};
+            float u = static_cast<float>(x) / size;
+            float v = static_cast<float>(y) / size;
+            vertex.position = {u, std::sin(u * 20.0f) * std::cos(v * 20.0f) * 0.05f, v};
+            vertex.normal = {0.0f, 1.0f, 0.0f};
+            vertex.texCoord = {u, v};
+            vertex.color = glm::vec3(1.0f, 1.0f, 1.0f);
+            return vertex;
+        };
+        std::vector<Vertex> corners;
+        corners.reserve(static_cast<size_t>(size) * size * 6);
+        for (int y = 0; y < size; ++y)
+        {
+            for (int x = 0; x < size; ++x)
+            {
+                Vertex v00 = gridVertex(x, y), v10 = gridVertex(x + 1, y), v11 = gridVertex(x + 1, y + 1), v01 = gridVertex(x, y + 1);
+                corners.insert(corners.end(), {v00, v10, v11, v00, v11, v01});
+            }
+        }
+        return corners;
+    }
+
+    template <typename Weld>
+    double bestOf(int runs, const std::vector<Vertex> &corners, Weld weld, WeldResult &result)
+    {
+        double best = 1e30;
+        for (int run = 0; run < runs; ++run)
+        {
+            auto start = std::chrono::steady_clock::now();
+            result = weld(corners);
+            best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+    bool benchmark(const std::string &name, const std::vector<Vertex> &corners, int runs)
+    {
+        WeldResult mapResult, tableResult;
+        double mapMs = bestOf(runs, corners, weldUnorderedMap, mapResult);
+        double tableMs = bestOf(runs, corners, weldTable, tableResult);
+
+        bool same = mapResult.indices == tableResult.indices && mapResult.vertices.size() == tableResult.vertices.size() &&
+                    std::memcmp(mapResult.vertices.data(), tableResult.vertices.data(), mapResult.vertices.size() * sizeof(Vertex)) == 0;
+
+        std::cout << name << ": " << corners.size() << " corners, " << tableResult.vertices.size() << " unique vertices" << std::endl;
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "    unordered_map    " << std::setw(10) << mapMs << " ms" << std::endl;
+        std::cout << "    VertexWeldTable  " << std::setw(10) << tableMs << " ms  (" << std::setprecision(2) << mapMs / tableMs << "x)" << std::endl;
+        if (!same)
+            std::cerr << "    results differ" << std::endl;
+        return same;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string modelPath = argc > 1 ? argv[1] : "assets/suzanne.obj";
+    int gridSize = argc > 2 ? std::max(1, std::atoi(argv[2])) : 1200;
+
+    bool ok = true;
+    std::vector<Vertex> corners;
+    if (loadCorners(modelPath, corners))
+        ok &= benchmark(modelPath, corners, 50);
+    else
+    {
+        std::cerr << "Failed to load " << modelPath << std::endl;
+        ok = false;
+    }
+
+    ok &= benchmark("grid " + std::to_string(gridSize) + "x" + std::to_string(gridSize), gridCorners(gridSize), 3);
+    return ok ? 0 : 1;
+}